@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "calculator.h"
+#include "postfix.h"
+#include "autodiff.h"
+
+/*
+Returns the number of inputs (numbers written in the expression) that the gradient is taken with respect to
+*/
+int countInputs(Postfix* p) {
+    int count = 0;
+    for(int i = 0; i < p->length; i++) {
+        count += p->tokens[i].op == NUMBER_TOKEN;
+    }
+    return count;
+}
+
+/*
+Returns the largest number of operands that are waiting on the stack at once while evaluating the expression
+*/
+static int maxStackDepth(Postfix* p) {
+    int depth = 0;
+    int maxDepth = 0;
+    for(int i = 0; i < p->length; i++) {
+        depth += 1 - operandCount(p->tokens[i].op);
+        if(depth > maxDepth) {
+            maxDepth = depth;
+        }
+    }
+    return maxDepth;
+}
+
+/*
+Applies an operator to dual numbers using the chain rule. The value is computed by evaluateOp so that errors are detected the same way.
+result: Stores the result. It may be the same as a.
+b: The second operand, or NULL for unary operators
+y: The value of b, or the exponent of INTEGER_POWER_TOKEN
+Returns the value of the result, or NAN if the operation is invalid
+*/
+static double applyDual(char op, Dual* a, Dual* b, double y, Dual* result, int n) {
+    double x = a->value;
+    double value = evaluateOp(op, x, y);
+    if(isnan(value)) {
+        return NAN;
+    }
+
+    switch(op) {
+        case '+':
+            for(int i = 0; i < n; i++) result->partials[i] = a->partials[i] + b->partials[i];
+            break;
+        case '-':
+            for(int i = 0; i < n; i++) result->partials[i] = a->partials[i] - b->partials[i];
+            break;
+        case '*':
+            for(int i = 0; i < n; i++) result->partials[i] = a->partials[i] * y + x * b->partials[i];
+            break;
+        case '/':
+            //d(x/y) = (dx - (x/y)dy) / y
+            for(int i = 0; i < n; i++) result->partials[i] = (a->partials[i] - value * b->partials[i]) / y;
+            break;
+        case '^': {
+            //d(x^y) = y*x^(y-1)dx + x^y*ln(x)dy. Each term is only added where it is needed, so a negative base only
+            //makes the partials of the exponent's inputs undefined instead of every partial.
+            double powerRule = y * pow(x, y - 1);
+            double exponentRule = value * log(x);
+            for(int i = 0; i < n; i++) {
+                result->partials[i] = (a->partials[i] != 0 ? powerRule * a->partials[i] : 0) +
+                    (b->partials[i] != 0 ? exponentRule * b->partials[i] : 0);
+            }
+            break;
+        }
+        case INTEGER_POWER_TOKEN: {
+            //d(x^n) = n*x^(n-1)dx. The exponent is not an input of the expression.
+            double derivative = y * evaluateOp(op, x, y - 1);
+            for(int i = 0; i < n; i++) result->partials[i] = a->partials[i] != 0 ? derivative * a->partials[i] : 0;
+            break;
+        }
+        case 's': {
+            double derivative = cos(x);
+            for(int i = 0; i < n; i++) result->partials[i] = derivative * a->partials[i];
+            break;
+        }
+        case 'c': {
+            double derivative = -sin(x);
+            for(int i = 0; i < n; i++) result->partials[i] = derivative * a->partials[i];
+            break;
+        }
+        case 't': {
+            double derivative = 1 + value * value; //sec^2(x) = 1 + tan^2(x)
+            for(int i = 0; i < n; i++) result->partials[i] = derivative * a->partials[i];
+            break;
+        }
+        case 'o': {
+            double derivative = -(1 + value * value); //-csc^2(x) = -(1 + cot^2(x))
+            for(int i = 0; i < n; i++) result->partials[i] = derivative * a->partials[i];
+            break;
+        }
+        case 'n': {
+            double derivative = 1 / x;
+            for(int i = 0; i < n; i++) result->partials[i] = derivative * a->partials[i];
+            break;
+        }
+        case 'l': {
+            double derivative = 1 / (x * log(10.0));
+            for(int i = 0; i < n; i++) result->partials[i] = derivative * a->partials[i];
+            break;
+        }
+        case 'm':
+            for(int i = 0; i < n; i++) result->partials[i] = -a->partials[i];
+            break;
+        default:
+            return NAN;
+    }
+    result->value = value;
+    return value;
+}
+
+/*
+Evaluates a compiled expression with forward-mode automatic differentiation.
+The value and the partial derivative with respect to every input are found in a single pass, instead of one extra evaluation per input.
+gradient: Must have room for countInputs(p) values. Entry i is set to the partial derivative with respect to the i-th number in the expression.
+Returns a double of the expression result
+Returns NAN if an error has occurred
+*/
+double evaluateGradient(Postfix* p, double* gradient) {
+    int n = countInputs(p);
+    int depth = maxStackDepth(p);
+    Dual* stack = (Dual *)malloc(depth * sizeof(Dual));
+    double* partials = (double *)malloc((size_t)depth * n * sizeof(double));
+    if(stack == NULL || partials == NULL) {
+        printf("Memory allocation failed.\n");
+        free(stack);
+        free(partials);
+        return NAN;
+    }
+    for(int i = 0; i < depth; i++) {
+        stack[i].partials = partials + (size_t)i * n;
+    }
+
+    int top = -1;
+    int input = 0; //The index of the next number in the expression
+    double result = NAN;
+    for(int i = 0; i < p->length; i++) {
+        char op = p->tokens[i].op;
+        double value;
+        if(op == NUMBER_TOKEN) {
+            //Each number is an input, so its derivative is 1 with respect to itself and 0 with respect to the others
+            top++;
+            memset(stack[top].partials, 0, n * sizeof(double));
+            stack[top].partials[input++] = 1;
+            stack[top].value = value = p->tokens[i].value;
+        } else if(operandCount(op) == 1) {
+            value = applyDual(op, &stack[top], NULL, p->tokens[i].value, &stack[top], n);
+        } else {
+            top--;
+            value = applyDual(op, &stack[top], &stack[top+1], stack[top+1].value, &stack[top], n);
+        }
+
+        if(isnan(value)) {
+            printf("Error: Invalid operation.\n");
+            top = -1;
+            break;
+        }
+    }
+
+    if(top == 0) {
+        result = stack[0].value;
+        memcpy(gradient, stack[0].partials, n * sizeof(double));
+    }
+    free(stack);
+    free(partials);
+    return result;
+}
+
+/*
+Compiles and differentiates an expression in one call
+gradient: Set to a newly allocated array of partial derivatives that the caller must free, or NULL if an error has occurred
+numInputs: Set to the number of entries in gradient
+Returns a double of the expression result
+Returns NAN if an error has occurred or input was invalid
+*/
+double evaluateExpressionGradient(char* exp, double** gradient, int* numInputs) {
+    Postfix postfix;
+    initPostfix(&postfix);
+    *gradient = NULL;
+    *numInputs = 0;
+    if(compileExpression(exp, &postfix)) {
+        freePostfix(&postfix);
+        return NAN;
+    }
+
+    *numInputs = countInputs(&postfix);
+    *gradient = (double *)malloc(*numInputs * sizeof(double));
+    double result = NAN;
+    if(*gradient == NULL) {
+        printf("Memory allocation failed.\n");
+    } else {
+        result = evaluateGradient(&postfix, *gradient);
+    }
+    if(isnan(result)) {
+        free(*gradient);
+        *gradient = NULL;
+    }
+    freePostfix(&postfix);
+    return result;
+}
@@ -0,0 +1,19 @@
+#ifndef autodiff_h
+#define autodiff_h
+
+#include "postfix.h"
+
+/*
+A dual number: a value together with its partial derivatives with respect to every input of the expression.
+The inputs are the numbers written in the expression, in the order they appear.
+*/
+typedef struct{
+    double value;
+    double* partials;
+} Dual;
+
+int countInputs(Postfix* p);
+double evaluateGradient(Postfix* p, double* gradient);
+double evaluateExpressionGradient(char* exp, double** gradient, int* numInputs);
+
+#endif
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <stdatomic.h>
+#include "calculator.h"
+#include "budget.h"
+
+/*
+Sets a budget to the default limits and clears its cancellation flag
+*/
+void initBudget(EvalBudget* budget) {
+    budget->maxTokens = DEFAULT_MAX_TOKENS;
+    budget->maxDepth = DEFAULT_MAX_DEPTH;
+    budget->maxExponentChain = DEFAULT_MAX_EXPONENT_CHAIN;
+    budget->maxSteps = DEFAULT_MAX_STEPS;
+    atomic_init(&budget->cancelled, 0);
+}
+
+/*
+Asks every evaluation using this budget to stop at its next step. The evaluation returns NAN with the status EVAL_CANCELLED.
+It is safe to call from another thread or from a signal handler (for example a SIGALRM timeout).
+*/
+void cancelEvaluation(EvalBudget* budget) {
+    atomic_store(&budget->cancelled, 1);
+}
+
+/*
+Measures the cost of an expression in one pass, without evaluating or validating it.
+An exponent chain continues through brackets, so 2^(3^(4^5)) has a chain of 3, while 2^3*4^5 has two chains of 1.
+maxTokens: The scan stops once more than this many tokens have been counted (if it is greater than 0), so measuring a huge expression stays cheap.
+           The other parts of the cost only cover the part of the expression that was scanned.
+*/
+void measureCost(char* exp, ExpressionCost* cost, int maxTokens) {
+    int chain[MAX_BRACKET_DEPTH + 1] = {0}; //The height of the current exponent chain at each open bracket depth
+    int tallest[MAX_BRACKET_DEPTH + 1] = {0}; //The tallest exponent chain that has ended at each open bracket depth
+    int depth = 0;
+    int i = 0;
+
+    cost->tokens = 0;
+    cost->depth = 0;
+    cost->exponentChain = 0;
+
+    while(exp[i] != '\0' && (maxTokens <= 0 || cost->tokens <= maxTokens)) {
+        char token = exp[i];
+        cost->tokens++;
+        if(isNumber(token)) {
+            while(isNumber(exp[i])) i++;
+            continue;
+        }
+        if(isalpha(token)) {//A function name is one token
+            while(isalpha(exp[i])) i++;
+            continue;
+        }
+
+        if(token == '(' || token == '{') {
+            depth++;
+            if(depth > cost->depth) {
+                cost->depth = depth;
+            }
+            if(depth > MAX_BRACKET_DEPTH) {//Nothing this deep can be evaluated, so the rest doesn't need to be measured
+                return;
+            }
+            chain[depth] = 0;
+            tallest[depth] = 0;
+        } else if((token == ')' || token == '}') && depth > 0) {
+            //The tallest chain inside the brackets continues the chain the brackets are part of
+            int inner = chain[depth] > tallest[depth] ? chain[depth] : tallest[depth];
+            depth--;
+            chain[depth] += inner;
+        } else if(token == '^') {
+            chain[depth]++;
+        } else if(token == '+' || token == '-' || token == '*' || token == '/') {
+            //Any other operator ends the chain
+            if(chain[depth] > tallest[depth]) {
+                tallest[depth] = chain[depth];
+            }
+            chain[depth] = 0;
+        }
+        if(chain[depth] > cost->exponentChain) {
+            cost->exponentChain = chain[depth];
+        }
+        i++;
+    }
+}
+
+/*
+Checks the cost of an expression against a budget before it is evaluated
+Returns EVAL_OK if the expression is within the budget, or EVAL_BUDGET_EXCEEDED if it is not
+*/
+int checkBudget(char* exp, EvalBudget* budget) {
+    ExpressionCost cost;
+    measureCost(exp, &cost, budget->maxTokens);
+    if((budget->maxTokens > 0 && cost.tokens > budget->maxTokens) ||
+        (budget->maxDepth > 0 && cost.depth > budget->maxDepth) ||
+        (budget->maxExponentChain > 0 && cost.exponentChain > budget->maxExponentChain)) {
+        return EVAL_BUDGET_EXCEEDED;
+    }
+    return EVAL_OK;
+}
+
+/*
+Counts one step of an evaluation against its budget. It is called by the evaluation loop for every token and every operation.
+steps: The number of steps the evaluation has taken so far, which is incremented
+Returns EVAL_OK if the evaluation can continue, EVAL_BUDGET_EXCEEDED if it has used all of its steps, or EVAL_CANCELLED if it was cancelled
+*/
+int spendStep(EvalBudget* budget, long* steps) {
+    if(atomic_load_explicit(&budget->cancelled, memory_order_relaxed)) {
+        return EVAL_CANCELLED;
+    }
+    (*steps)++;
+    if(budget->maxSteps > 0 && *steps > budget->maxSteps) {
+        return EVAL_BUDGET_EXCEEDED;
+    }
+    return EVAL_OK;
+}
@@ -0,0 +1,40 @@
+#ifndef budget_h
+#define budget_h
+
+#include <stdatomic.h>
+#include "validator.h"
+
+//The status of a budgeted evaluation
+#define EVAL_OK 0 //The expression was evaluated
+#define EVAL_ERROR 1 //The expression is invalid or an operation was undefined
+#define EVAL_BUDGET_EXCEEDED 2 //The expression costs more than the budget allows, so it was not evaluated (or evaluation was stopped)
+#define EVAL_CANCELLED 3 //cancelEvaluation was called while the expression was being evaluated
+
+#define DEFAULT_MAX_TOKENS 100000 //The default number of tokens (numbers, operators, function names and brackets) in one expression
+#define DEFAULT_MAX_DEPTH 32 //The default deepest bracket nesting
+#define DEFAULT_MAX_EXPONENT_CHAIN 8 //The default tallest chain of ^ operators, such as 2^3^4 or 2^(3^4), which has a height of 2
+#define DEFAULT_MAX_STEPS (2L * DEFAULT_MAX_TOKENS) //The default number of evaluation steps. Every token and every operation is one step.
+
+// The limits for evaluating one expression. Any limit that is 0 or less is not checked.
+typedef struct{
+    int maxTokens;
+    int maxDepth;
+    int maxExponentChain;
+    long maxSteps;
+    atomic_int cancelled; //Set by cancelEvaluation, from another thread or a signal handler
+} EvalBudget;
+
+// The cost of an expression, measured before it is evaluated
+typedef struct{
+    int tokens;
+    int depth; //The deepest bracket nesting
+    int exponentChain; //The tallest chain of ^ operators
+} ExpressionCost;
+
+void initBudget(EvalBudget* budget);
+void cancelEvaluation(EvalBudget* budget);
+void measureCost(char* exp, ExpressionCost* cost, int maxTokens);
+int checkBudget(char* exp, EvalBudget* budget);
+int spendStep(EvalBudget* budget, long* steps);
+
+#endif
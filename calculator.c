@@ -5,6 +5,10 @@
 #include <math.h>
 #include "stack.h"
 #include "calculator.h"
+#include "validator.h"
+#include "budget.h"
+
+static double evaluateInfix(char** input, EvalBudget* budget, int* status);
 
 //For testing, the main function must be commented out so that the entry point of the program can occur in test_calculator.c
 /*int main() {
@@ -84,11 +88,81 @@ Returns a double of the expression result
 Returns NAN if an error has occurred or input was invalid
 */
 double evaluateExpression(char** input) {
+    int status;
+    return evaluateExpressionBudget(input, NULL, &status);
+}
+
+/*
+Counts one step of an evaluation against its budget, if it has one
+status: Set to EVAL_BUDGET_EXCEEDED or EVAL_CANCELLED if the evaluation has to stop
+Returns true if the evaluation has to stop, returns false if it can continue
+*/
+static bool stopEvaluation(EvalBudget* budget, long* steps, int* status) {
+    if(budget == NULL) {
+        return false;
+    }
+    int result = spendStep(budget, steps);
+    if(result == EVAL_OK) {
+        return false;
+    }
+    if(result == EVAL_CANCELLED) {
+        printf("Error: Evaluation was cancelled.\n");
+    } else {
+        printf("Error: Expression exceeds the evaluation budget.\n");
+    }
+    *status = result;
+    return true;
+}
+
+/*
+Evaluates an expression within a budget, so that no single expression can take an unbounded amount of time.
+The cost of the expression is checked against the budget before anything is evaluated,
+and the evaluation stops early if it runs out of steps or is cancelled.
+budget: The limits for this expression, or NULL for no limits
+status: Set to EVAL_OK, EVAL_ERROR, EVAL_BUDGET_EXCEEDED or EVAL_CANCELLED
+Returns the result, or NAN if status is not EVAL_OK
+*/
+double evaluateExpressionBudget(char** input, EvalBudget* budget, int* status) {
+    *status = EVAL_ERROR; //Changed to EVAL_OK once the result has been found
+
+    //The cost is checked first because it only scans as far as the token limit
+    if(budget != NULL && checkBudget(*input, budget) != EVAL_OK) {
+        printf("Error: Expression exceeds the evaluation budget.\n");
+        *status = EVAL_BUDGET_EXCEEDED;
+        return NAN;
+    }
+
+    //Reject malformed input in a single pass before any operands are pushed or partial results are computed
+    if(!validateExpression(*input)) {
+        printf("Error: Invalid input\n");
+        return NAN;
+    }
+    return evaluateInfix(input, budget, status);
+}
+
+/*
+Evaluates an expression that has already passed validateExpression, such as a term split out of a larger valid expression,
+without validating it again
+Returns a double of the expression result
+Returns NAN if an error has occurred
+*/
+double evaluateValidatedExpression(char* exp) {
+    int status;
+    return evaluateInfix(&exp, NULL, &status);
+}
+
+/*
+The shunting-yard evaluation behind evaluateExpressionBudget, once the input has been validated
+status: Set to EVAL_OK if a result was found, otherwise left unchanged unless the budget stopped the evaluation
+*/
+static double evaluateInfix(char** input, EvalBudget* budget, int* status) {
+    long steps = 0; //The number of steps counted against the budget
+
     Operators operators;
     initOperator(&operators);
 
     Operators braceStack;
-    initOperator(&operators);//Stores () and {} to ensure the pairs match correctly
+    initOperator(&braceStack);//Stores () and {} to ensure the pairs match correctly
 
     Operands operands;
     initOperand(&operands);
@@ -97,13 +171,15 @@ double evaluateExpression(char** input) {
     int inputIndex = 0;
 
     while((*input)[inputIndex] != '\0') {
+        if(stopEvaluation(budget, &steps, status)) {
+            return NAN;
+        }
         char token = (*input)[inputIndex];
         if(isNumber(token)) {
             double value = findNumber((*input), &inputIndex);
-            if(isnan(value)) {
+            if(isnan(value) || pushOperand(&operands, value)) {
                 return NAN;
             }
-            pushOperand(&operands, value);
         } else if(isOperator(token)) {
             char op = '\0';//Stores the current operator
             if(token == '-') {
@@ -137,18 +213,30 @@ double evaluateExpression(char** input) {
                     peekOperator(&operators) != '{' && 
                     precedence(peekOperator(&operators)) >= precedence(op)
             ) {
+                if(stopEvaluation(budget, &steps, status)) {
+                    return NAN;
+                }
                 char stackOp = popOperator(&operators);
+                double result = NAN;
                 if(isUnary(stackOp) || stackOp == 'm') {
                     double a = popOperand(&operands);
-                    pushOperand(&operands, evaluateOp(stackOp, a, 0));
+                    result = evaluateOp(stackOp, a, 0);
                 } else {
                     double b = popOperand(&operands);
                     double a = popOperand(&operands);
-                    pushOperand(&operands, evaluateOp(stackOp, a, b));
+                    result = evaluateOp(stackOp, a, b);
                 }
+                //Stop at the first invalid operation, otherwise a later operation such as ^0 could hide the error
+                if(isnan(result)) {
+                    printf("Error: Invalid operation.\n");
+                    return NAN;
+                }
+                pushOperand(&operands, result);
             }
 
-            pushOperator(&operators, op);
+            if(pushOperator(&operators, op)) {
+                return NAN;
+            }
         } else if(token == '(' || token == '{') {
             //An open bracket can't be the last character in an expression
             //and an open brack can't be immediately followed by a closing bracket
@@ -158,8 +246,9 @@ double evaluateExpression(char** input) {
                 printf("Error: Invalid use of brackets.\n");
                 return NAN;
             }
-            pushOperator(&operators, token);
-            pushOperator(&braceStack, token);
+            if(pushOperator(&operators, token) || pushOperator(&braceStack, token)) {
+                return NAN;
+            }
             inputIndex++;
         } else if(token == ')' || token == '}') {
             //If the opening and closing brackets don't match in type, return an error
@@ -169,6 +258,9 @@ double evaluateExpression(char** input) {
                 return NAN;
             }
             while(operators.top >= 0 && peekOperator(&operators) != '(' && peekOperator(&operators) != '{') {
+                if(stopEvaluation(budget, &steps, status)) {
+                    return NAN;
+                }
                 char stackOp = popOperator(&operators);
                 double result = NAN;
                 if(isUnary(stackOp) || stackOp == 'm') {
@@ -201,6 +293,9 @@ double evaluateExpression(char** input) {
     }
 
     while (operators.top >= 0) {
+        if(stopEvaluation(budget, &steps, status)) {
+            return NAN;
+        }
         char op = popOperator(&operators);
         double result = NAN;
         if(isUnary(op) || op == 'm') {
@@ -226,6 +321,9 @@ double evaluateExpression(char** input) {
     }
 
     double result = popOperand(&operands); //Get the result from the last operand on the stack
+    if(!isnan(result)) {
+        *status = EVAL_OK;
+    }
     return result;
 }
 
@@ -344,7 +442,7 @@ char findOperator(char* exp, int* i) {
         //Binary operators must be followed by a digit, an open brace, or a unary operator to be valid
         if(isdigit(exp[(*i)+1]) || exp[(*i)+1] == '(' || exp[(*i)+1] == '{' || isUnary(exp[(*i)+1]) || exp[(*i)+1] == '-') {
             //Operators must be preceded by a digit or closing brace to be valid
-            if(isdigit(exp[(*i)-1]) || exp[(*i)-1] == ')' || exp[(*i)-1] == '}') {
+            if((*i) > 0 && (isdigit(exp[(*i)-1]) || exp[(*i)-1] == ')' || exp[(*i)-1] == '}')) {
                 return exp[(*i)++];//Return the operator and move to the next index
             } else {
                 return '\0'; //The preceding character was invalid
@@ -443,16 +541,18 @@ double evaluateOp(char op, double a, double b) {
     double result;
     switch(op) {
         case '+': 
-            if(a > DBL_MAX - b) {//Check if the addition will overflow the double
+            result = a+b;
+            if(isinf(result)) {//Check if the addition overflowed the double in either direction
                 return NAN;
             } else {
-                return a+b;
+                return result;
             }
         case '-': 
-            if(a > NAN + b) {//Check if the subtraction will overflow the negative double
+            result = a-b;
+            if(isinf(result)) {//Check if the subtraction overflowed the double in either direction
                 return NAN;
             } else {
-                return a-b;
+                return result;
             }
         case '*': 
             if(fabs(a) > DBL_MAX/fabs(b)) {//Check if the multiplication with overflow double
@@ -463,8 +563,12 @@ double evaluateOp(char op, double a, double b) {
         case '/': 
             if (b == 0) {
                 return NAN;
+            }
+            result = a/b;
+            if(isinf(result)) {//Check if dividing by a tiny number overflowed the double
+                return NAN;
             } else {
-                return a/b;
+                return result;
             }
         case '^': 
             result = pow(a, b);
@@ -477,10 +581,15 @@ double evaluateOp(char op, double a, double b) {
         case 'c': return cos(a);
         case 't': return tan(a);
         case 'o': 
-            if(tan(a) == 0) {//Check if there will be a division by 0 error
+            result = tan(a);//Only compute tan once for the check and the division
+            if(result == 0) {//Check if there will be a division by 0 error
+                return NAN;
+            }
+            result = 1.0/result;
+            if(isinf(result)) {//The tangent of a tiny number is too small to divide by
                 return NAN;
             } else {
-                return 1.0/tan(a);
+                return result;
             }
         case 'n': 
             //Natural logarithm is only defined for positive numbers.
@@ -497,6 +606,33 @@ double evaluateOp(char op, double a, double b) {
                 return NAN;
             }
         case 'm': return -1*a; //Unary minus, negate one operand
+        case 'q': {//Integer power created by optimizePostfix. b is a small whole number, so a chain of multiplications can replace pow
+            //The chain only matches pow when it rounds at most once: x^0, x^1 and x^2, or a whole base whose power is an exact integer.
+            //Any other base goes straight to pow, so the chain is never computed only to be thrown away.
+            if(fabs(b) > 1 && b != 2 && a != floor(a)) {
+                result = pow(a, b);
+            } else {
+                double base = a;
+                result = 1;
+                for(int n = (int)fabs(b); n > 0; n >>= 1) {
+                    if(n & 1) {
+                        result *= a;
+                    }
+                    a *= a;
+                }
+                //A whole base that is at least 1 only grows, so if the final power is at most 2^53 every product before it was exact too
+                if(fabs(b) > 1 && b != 2 && fabs(result) > MAX_EXACT_INTEGER) {
+                    result = pow(base, b);
+                } else if(b < 0) {
+                    result = 1.0/result;
+                }
+            }
+            if(isinf(result)) {//Check for exponent overflow.
+                return NAN;
+            } else {
+                return result;
+            }
+        }
         default: return NAN;
     }
 }
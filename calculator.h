@@ -2,8 +2,10 @@
 #define calculator_h
 
 #include <stdbool.h>
+#include "budget.h"
 
 #define INITIAL_CAPACITY 20 //The initial number of characters of the user-input expression
+#define MAX_EXACT_INTEGER 9007199254740992.0 //2^53. Every whole number up to this size is exactly representable as a double.
 
 int getInput(char** exp);
 bool isNumber(char value);
@@ -12,6 +14,8 @@ bool isOperator(char op);
 bool isUnary(char op);
 char findOperator(char* exp, int* i);
 double evaluateExpression(char** input);
+double evaluateExpressionBudget(char** input, EvalBudget* budget, int* status);
+double evaluateValidatedExpression(char* exp);
 double evaluateOp(char op, double a, double b);
 int precedence(char op);
 
@@ -0,0 +1,206 @@
+import csv
+import sys
+import heapq
+import os
+import tempfile
+
+############### Canonicalize and deduplicate expression corpora ###############
+# Usage:
+#   python3 corpus_dedup.py dedup <input.csv> <unique.csv> <mapping.csv> [chunk rows]
+#       Canonicalizes every expression in input.csv (expression, expected result) and writes each distinct
+#       (canonical expression, expected result) pair once to unique.csv. mapping.csv lists the unique row id of every input row.
+#   python3 corpus_dedup.py expand <mapping.csv> <unique_results.csv> <results.csv> [chunk rows]
+#       unique_results.csv has one row per row of unique.csv, in the same order (for example a pass/fail verdict).
+#       Writes one row per original input row, in the original order: the input row number followed by its unique row's columns.
+#
+# Both commands sort with a chunked external merge sort, so corpora larger than memory can be processed.
+# At most [chunk rows] rows are held in memory at once.
+
+DEFAULT_CHUNK_ROWS = 1000000 # The number of rows sorted in memory before they are written to a temporary file
+MAX_MERGE_FILES = 64 # The most chunk files open at once while merging, so large corpora don't run out of file handles
+
+# Converts an expression to the form the evaluator actually sees.
+# Like getInput, spaces and tabs are removed and letters are lowercased.
+# Curly brackets are replaced with parentheses, because the evaluator treats the two the same once they are matched correctly.
+# They are left alone if the brackets don't match (so an invalid expression stays invalid)
+# or if they follow a function name, because functions must be followed by '(' in calculator.c.
+# @param expression The expression as it appears in the corpus
+# @return The canonical expression
+def canonicalize(expression):
+    expression = expression.replace(' ', '').replace('\t', '').lower()
+    if '{' not in expression:
+        return expression
+
+    chars = list(expression)
+    openBrackets = [] # Positions of the brackets that haven't been closed yet
+    replace = [] # Positions of matched {} pairs that can be replaced
+    for index, char in enumerate(chars):
+        if char == '(' or char == '{':
+            openBrackets.append(index)
+        elif char == ')' or char == '}':
+            if len(openBrackets) == 0:
+                return expression # An unmatched closing bracket
+            opening = openBrackets.pop()
+            if (chars[opening] == '(') != (char == ')'):
+                return expression # The bracket types don't match
+            if char == '}' and (opening == 0 or not chars[opening-1].isalpha()):
+                replace.append((opening, index))
+    if len(openBrackets) != 0:
+        return expression # An unclosed bracket
+
+    for opening, closing in replace:
+        chars[opening] = '('
+        chars[closing] = ')'
+    return ''.join(chars)
+
+# Writes rows to a new temporary csv file
+# @param rows The rows to be written
+# @param tempDir The directory to create the file in
+# @return The path of the file
+def writeChunk(rows, tempDir):
+    handle, path = tempfile.mkstemp(suffix='.csv', dir=tempDir)
+    with os.fdopen(handle, mode='w', newline='') as file:
+        csv.writer(file).writerows(rows)
+    return path
+
+# Reads the rows of a temporary chunk file one at a time
+# @param path The path of the chunk file
+# @return A generator of rows
+def readChunk(path):
+    with open(path, mode='r', newline='') as file:
+        for row in csv.reader(file):
+            yield row
+
+# Merges sorted chunk files until at most MAX_MERGE_FILES are left. Each pass merges groups of MAX_MERGE_FILES files
+# into one new file and deletes them, so no more than MAX_MERGE_FILES + 1 files are open at once.
+# @param paths The paths of the sorted chunk files, in the order they were written
+# @param key The function that gives the sort key of a row
+# @param tempDir The directory for the temporary chunk files
+# @return The paths of the remaining chunk files
+def reduceChunks(paths, key, tempDir):
+    while len(paths) > MAX_MERGE_FILES:
+        merged = []
+        for start in range(0, len(paths), MAX_MERGE_FILES):
+            group = paths[start:start + MAX_MERGE_FILES]
+            if len(group) == 1:
+                merged.append(group[0]) # Nothing to merge it with in this pass
+                continue
+            merged.append(writeChunk(heapq.merge(*[readChunk(path) for path in group], key=key), tempDir))
+            for path in group:
+                os.remove(path)
+        paths = merged
+    return paths
+
+# Sorts rows that may not fit in memory. Rows are sorted in chunks of chunkRows, each sorted chunk is written to a temporary file,
+# and the files are merged, in several passes if there are more than MAX_MERGE_FILES of them.
+# @param rows An iterable of rows (lists of strings)
+# @param key The function that gives the sort key of a row
+# @param chunkRows The largest number of rows to hold in memory
+# @param tempDir The directory for the temporary chunk files
+# @return A generator of the rows in sorted order
+def externalSort(rows, key, chunkRows, tempDir):
+    paths = []
+    chunk = []
+    for row in rows:
+        chunk.append(row)
+        if len(chunk) == chunkRows:
+            chunk.sort(key=key)
+            paths.append(writeChunk(chunk, tempDir))
+            chunk = []
+    chunk.sort(key=key)
+
+    if len(paths) == 0: # Everything fit in one chunk, so there's nothing to merge
+        yield from chunk
+        return
+    if len(chunk) > 0:
+        paths.append(writeChunk(chunk, tempDir))
+    paths = reduceChunks(paths, key, tempDir)
+    yield from heapq.merge(*[readChunk(path) for path in paths], key=key)
+
+# Reads the rows of a corpus, skipping a UTF-8 BOM if there is one
+# @param fileName The path of the csv file to be read
+# @return A generator of rows
+def readCorpus(fileName):
+    with open(fileName, mode='r', newline='', encoding='utf-8-sig') as file:
+        for row in csv.reader(file):
+            yield row
+
+# Canonicalizes and deduplicates a corpus
+# @param inputFile The corpus of (expression, expected result) rows
+# @param uniqueFile The path to write the unique (canonical expression, expected result) rows to
+# @param mappingFile The path to write (unique row id, input row number) rows to
+# @param chunkRows The largest number of rows to hold in memory
+def dedup(inputFile, uniqueFile, mappingFile, chunkRows):
+    # Each record is [canonical expression, expected result, input row number]
+    def records():
+        for rowNumber, row in enumerate(readCorpus(inputFile)):
+            if len(row) < 2 or row[0].strip() == '':
+                continue # Skip empty lines, the same as test_calculator.c
+            yield [canonicalize(row[0]), row[1].strip(), str(rowNumber)]
+
+    numRows = 0
+    numUnique = 0
+    previous = None
+    with tempfile.TemporaryDirectory() as tempDir, \
+        open(uniqueFile, mode='w', newline='') as unique, \
+        open(mappingFile, mode='w', newline='') as mapping:
+        uniqueWriter = csv.writer(unique)
+        mappingWriter = csv.writer(mapping)
+
+        for record in externalSort(records(), lambda r: (r[0], r[1], int(r[2])), chunkRows, tempDir):
+            if record[:2] != previous: # Sorted order puts duplicates next to each other
+                previous = record[:2]
+                uniqueWriter.writerow(previous)
+                numUnique += 1
+            mappingWriter.writerow([numUnique - 1, record[2]])
+            numRows += 1
+
+    print(uniqueFile, "successfully written.", numRows, "rows,", numUnique, "unique.")
+
+# Expands per-unique-row results back to every original row
+# @param mappingFile The mapping written by dedup
+# @param uniqueResultsFile One row of results for each row of the unique file, in the same order
+# @param resultsFile The path to write (input row number, results...) rows to, in the original row order
+# @param chunkRows The largest number of rows to hold in memory
+def expand(mappingFile, uniqueResultsFile, resultsFile, chunkRows):
+    # The mapping is in unique row order, so it can be joined with the unique results by reading both files together
+    def joined():
+        results = readCorpus(uniqueResultsFile)
+        current = -1
+        result = None
+        for uniqueId, rowNumber in readCorpus(mappingFile):
+            while current < int(uniqueId):
+                result = next(results, None)
+                current += 1
+                if result is None:
+                    print("Error: " + uniqueResultsFile + " has fewer rows than the unique file.")
+                    sys.exit(1)
+            yield [rowNumber] + result
+
+    numRows = 0
+    with tempfile.TemporaryDirectory() as tempDir, open(resultsFile, mode='w', newline='') as file:
+        writer = csv.writer(file)
+        for row in externalSort(joined(), lambda r: int(r[0]), chunkRows, tempDir):
+            writer.writerow(row)
+            numRows += 1
+
+    print(resultsFile, "successfully written.", numRows, "rows.")
+
+################## Get command line parameters ##########################
+if len(sys.argv) not in (5, 6) or sys.argv[1] not in ("dedup", "expand"):
+    print("Error: usage is \n  python3 corpus_dedup.py dedup <input.csv> <unique.csv> <mapping.csv> [chunk rows]" +
+        "\n  python3 corpus_dedup.py expand <mapping.csv> <unique_results.csv> <results.csv> [chunk rows]")
+    sys.exit(1)
+
+try:
+    chunkRows = int(sys.argv[5]) if len(sys.argv) == 6 else DEFAULT_CHUNK_ROWS
+    if chunkRows <= 0:
+        raise ValueError
+except ValueError:
+    print("Error: chunk rows must be a positive integer.")
+    sys.exit(1)
+
+if sys.argv[1] == "dedup":
+    dedup(sys.argv[2], sys.argv[3], sys.argv[4], chunkRows)
+else:
+    expand(sys.argv[2], sys.argv[3], sys.argv[4], chunkRows)
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <fenv.h>
+#include <math.h>
+#include "stack.h"
+#include "calculator.h"
+#include "postfix.h"
+#include "deferred_eval.h"
+
+/*
+Performs an operation with plain floating-point arithmetic and none of the error checks in evaluateOp.
+Any error is recorded by the hardware in the floating-point exception flags instead.
+*/
+static double plainOp(char op, double a, double b) {
+    switch(op) {
+        case '+': return a+b;
+        case '-': return a-b;
+        case '*': return a*b;
+        case '/': return a/b;
+        case '^': return pow(a, b);
+        case 's': return sin(a);
+        case 'c': return cos(a);
+        case 't': return tan(a);
+        case 'o': return 1.0/tan(a);
+        case 'n': return log(a);
+        case 'l': return log10(a);
+        case 'm': return -a;
+        case INTEGER_POWER_TOKEN: return evaluateOp(op, a, b);
+        default: return NAN;
+    }
+}
+
+/*
+Evaluates a compiled expression without checking the floating-point exception flags
+Returns the result, or NAN if the operand stack would overflow or the expression is empty
+*/
+static double evaluatePlain(Postfix* p) {
+    double stack[MAX];
+    int top = -1;
+    for(int i = 0; i < p->length; i++) {
+        char op = p->tokens[i].op;
+        int count = operandCount(op);
+        if(count == 0) {
+            if(top == MAX - 1) {
+                return NAN;
+            }
+            stack[++top] = p->tokens[i].value;
+        } else if(count == 1) {
+            stack[top] = plainOp(op, stack[top], p->tokens[i].value);
+        } else {
+            top--;
+            stack[top] = plainOp(op, stack[top], stack[top+1]);
+        }
+    }
+    //An empty expression, such as one that failed to compile, leaves no result on the stack
+    return top == 0 ? stack[0] : NAN;
+}
+
+/*
+Evaluates a compiled expression with plain arithmetic, then checks the floating-point exception flags once at the end instead of
+checking every operation. In the rare case that an overflow, invalid operation, or division by zero happened, the expression is
+evaluated again with evaluatePostfix to find the error, so the result is the same as evaluatePostfix.
+Returns a double of the expression result
+Returns NAN if an error has occurred
+*/
+double evaluatePostfixDeferred(Postfix* p) {
+    fexcept_t flags;
+    fegetexceptflag(&flags, FE_ALL_EXCEPT); //Save the caller's flags and start with none raised
+    feclearexcept(FE_ALL_EXCEPT);
+
+    double result = evaluatePlain(p);
+    if(fetestexcept(DEFERRED_EXCEPTIONS) || !isfinite(result)) {
+        result = evaluatePostfix(p);
+    }
+
+    fesetexceptflag(&flags, FE_ALL_EXCEPT); //Put the caller's flags back so the ones raised by this expression don't leak out
+    return result;
+}
+
+/*
+Evaluates a batch of compiled expressions with plain arithmetic. The flags are cleared once for the whole batch and only checked once
+per expression, and only the expressions that raised an exception are evaluated again with evaluatePostfix.
+results: Must have room for count values. results[i] is set to the result of expressions[i], or NAN if an error has occurred.
+*/
+void evaluateBatchDeferred(Postfix* expressions, int count, double* results) {
+    fexcept_t flags;
+    fegetexceptflag(&flags, FE_ALL_EXCEPT);
+    feclearexcept(FE_ALL_EXCEPT);
+
+    for(int i = 0; i < count; i++) {
+        results[i] = evaluatePlain(&expressions[i]);
+        if(fetestexcept(DEFERRED_EXCEPTIONS) || !isfinite(results[i])) {
+            results[i] = evaluatePostfix(&expressions[i]);
+            feclearexcept(FE_ALL_EXCEPT);
+        }
+    }
+
+    fesetexceptflag(&flags, FE_ALL_EXCEPT);
+}
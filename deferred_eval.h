@@ -0,0 +1,12 @@
+#ifndef deferred_eval_h
+#define deferred_eval_h
+
+#include <fenv.h>
+#include "postfix.h"
+
+#define DEFERRED_EXCEPTIONS (FE_OVERFLOW | FE_INVALID | FE_DIVBYZERO) //The floating-point exceptions that mean an operation was invalid
+
+double evaluatePostfixDeferred(Postfix* p);
+void evaluateBatchDeferred(Postfix* expressions, int count, double* results);
+
+#endif
@@ -0,0 +1,510 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "calculator.h"
+#include "postfix.h"
+#include "expression_store.h"
+
+#define STORE_TABLE_CAPACITY 64 //The initial number of slots in each hash table. Must be a power of 2.
+#define INLINE_OPERAND(packed) (-2 - (packed)) //The decoded form of an inline number operand, kept apart from node ids (>= 0) and no operand (-1)
+#define IS_INLINE(operand) ((operand) < -1)
+
+static const double POWERS_OF_TEN[MAX_INLINE_DECIMALS + 1] = {1, 10, 100, 1000};
+
+static void insertEntry(int* table, int capacity, unsigned int hash, int value);
+
+void initStore(ExpressionStore* s) {
+    memset(s, 0, sizeof(ExpressionStore));
+}
+
+void freeStore(ExpressionStore* s) {
+    free(s->code);
+    free(s->nodeStarts);
+    free(s->nodeTable);
+    free(s->constants);
+    free(s->constantTable);
+    initStore(s);
+}
+
+/*
+Makes sure an array has room for at least one more item, doubling its capacity if it is full
+Returns 0 if there is room, returns 1 if memory allocation failed
+*/
+static int reserve(void** items, int* capacity, int length, size_t itemSize) {
+    if(length < *capacity) {
+        return 0;
+    }
+    int newCapacity = *capacity == 0 ? INITIAL_CAPACITY : *capacity * 2;
+    void* newItems = realloc(*items, newCapacity * itemSize);
+    if(newItems == NULL) {
+        printf("Memory allocation failed.\n");
+        return 1;
+    }
+    *items = newItems;
+    *capacity = newCapacity;
+    return 0;
+}
+
+/*
+Appends an unsigned integer to the code buffer using 7 bits per byte. The high bit of each byte is set if more bytes follow.
+Returns 0 if successful, returns 1 if memory allocation failed
+*/
+static int writeVarint(ExpressionStore* s, unsigned int value) {
+    do {
+        if(reserve((void**)&s->code, &s->codeCapacity, s->codeLength, sizeof(unsigned char))) {
+            return 1;
+        }
+        unsigned char byte = value & 0x7F;
+        value >>= 7;
+        s->code[s->codeLength++] = byte | (value != 0 ? 0x80 : 0);
+    } while(value != 0);
+    return 0;
+}
+
+/*
+Reads a varint written by writeVarint and moves code to the byte after it
+*/
+static unsigned int readVarint(const unsigned char** code) {
+    unsigned int value = 0;
+    int shift = 0;
+    unsigned char byte;
+    do {
+        byte = *(*code)++;
+        value |= (unsigned int)(byte & 0x7F) << shift;
+        shift += 7;
+    } while(byte & 0x80);
+    return value;
+}
+
+/*
+Records that a node starts at a position of the code buffer
+Returns 0 if successful, returns 1 if memory allocation failed
+*/
+static int markNodeStart(ExpressionStore* s, int id) {
+    int byte = id >> 3;
+    while(byte >= s->nodeStartsCapacity) {
+        int oldCapacity = s->nodeStartsCapacity;
+        if(reserve((void**)&s->nodeStarts, &s->nodeStartsCapacity, oldCapacity, sizeof(unsigned char))) {
+            return 1;
+        }
+        memset(s->nodeStarts + oldCapacity, 0, s->nodeStartsCapacity - oldCapacity);
+    }
+    s->nodeStarts[byte] |= 1 << (id & 7);
+    return 0;
+}
+
+static int isNodeStart(ExpressionStore* s, int id) {
+    return id >= 0 && id < s->codeLength && (s->nodeStarts[id >> 3] >> (id & 7) & 1);
+}
+
+/*
+Finds the inline form of a number: its digits m and decimal places k packed as m*4 + k, where the number is exactly m / 10^k
+Returns the packed number, or -1 if the number has to go in the constant pool
+*/
+static int packNumber(double value) {
+    if(!(value >= 0) || signbit(value)) {
+        return -1;
+    }
+    for(int k = 0; k <= MAX_INLINE_DECIMALS; k++) {
+        double scaled = nearbyint(value * POWERS_OF_TEN[k]);
+        if(scaled >= MAX_INLINE_MANTISSA) {
+            return -1;
+        }
+        if(scaled / POWERS_OF_TEN[k] == value) {
+            return (int)scaled << 2 | k;
+        }
+    }
+    return -1;
+}
+
+static double unpackNumber(int operand) {
+    int packed = -2 - operand;
+    return (packed >> 2) / POWERS_OF_TEN[packed & 3];
+}
+
+/*
+Appends an operand of the node at id: an inline number as (packed << 1) | 1, or a node as (distance back to it) << 1
+Returns 0 if successful, returns 1 if memory allocation failed
+*/
+static int writeOperand(ExpressionStore* s, int id, int operand) {
+    if(IS_INLINE(operand)) {
+        return writeVarint(s, (unsigned int)(-2 - operand) << 1 | 1);
+    }
+    return writeVarint(s, (unsigned int)(id - operand) << 1);
+}
+
+static int readOperand(const unsigned char** code, int id) {
+    unsigned int value = readVarint(code);
+    return value & 1 ? INLINE_OPERAND((int)(value >> 1)) : id - (int)(value >> 1);
+}
+
+/*
+Unpacks a node from the code buffer
+a: Set to the constant index for NUMBER_TOKEN, or the first operand
+b: Set to the second operand of a binary operator, or -1
+Operands are node ids, or INLINE_OPERAND of a packed number
+Returns the opcode of the node
+*/
+static char decodeNode(ExpressionStore* s, int id, int* a, int* b) {
+    const unsigned char* code = s->code + id;
+    char op = (char)*code++;
+    *b = -1;
+    if(op == NUMBER_TOKEN) {
+        *a = readVarint(&code);
+    } else {
+        *a = readOperand(&code, id);
+        if(!isUnary(op) && op != 'm') {
+            *b = readOperand(&code, id);
+        }
+    }
+    return op;
+}
+
+static unsigned int hashNode(char op, int a, int b) {
+    unsigned int hash = 2166136261u;
+    hash = (hash ^ (unsigned char)op) * 16777619u;
+    hash = (hash ^ (unsigned int)a) * 16777619u;
+    hash = (hash ^ (unsigned int)b) * 16777619u;
+    return hash ^ (hash >> 15);
+}
+
+static unsigned int hashConstant(double value) {
+    unsigned long long bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bits ^= bits >> 33;
+    bits *= 0xff51afd7ed558ccdULL;
+    bits ^= bits >> 33;
+    return (unsigned int)bits;
+}
+
+/*
+Doubles the capacity of a hash table once it is 70% full and reinserts every entry
+key: Returns the hash of entry x, where x is the stored value - 1
+Returns 0 if successful, returns 1 if memory allocation failed
+*/
+static int growTable(ExpressionStore* s, int** table, int* capacity, int count, unsigned int (*key)(ExpressionStore*, int)) {
+    if(*capacity != 0 && count * 10 < *capacity * 7) {
+        return 0;
+    }
+    int newCapacity = *capacity == 0 ? STORE_TABLE_CAPACITY : *capacity * 2;
+    int* newTable = (int *)calloc(newCapacity, sizeof(int));
+    if(newTable == NULL) {
+        printf("Memory allocation failed.\n");
+        return 1;
+    }
+    for(int i = 0; i < *capacity; i++) {
+        if((*table)[i] != 0) {
+            insertEntry(newTable, newCapacity, key(s, (*table)[i] - 1), (*table)[i]);
+        }
+    }
+    free(*table);
+    *table = newTable;
+    *capacity = newCapacity;
+    return 0;
+}
+
+static unsigned int nodeKey(ExpressionStore* s, int id) {
+    int a, b;
+    char op = decodeNode(s, id, &a, &b);
+    return hashNode(op, a, b);
+}
+
+static unsigned int constantKey(ExpressionStore* s, int index) {
+    return hashConstant(s->constants[index]);
+}
+
+/*
+Puts an existing entry (value - 1) into the first free slot of a hash table
+*/
+static void insertEntry(int* table, int capacity, unsigned int hash, int value) {
+    unsigned int slot = hash & (capacity - 1);
+    while(table[slot] != 0) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+    table[slot] = value;
+}
+
+/*
+Recreates the hash tables after sealStore has freed them, so that more expressions can be added
+Returns 0 if successful, returns 1 if memory allocation failed
+*/
+static int rebuildTables(ExpressionStore* s) {
+    if(s->nodeTable != NULL || s->nodeCount == 0) {
+        return 0;
+    }
+
+    int constantCount = s->constantCount;
+    s->constantCount = 0;
+    for(int i = 0; i < constantCount; i++) {
+        if(growTable(s, &s->constantTable, &s->constantTableCapacity, s->constantCount, constantKey)) {
+            return 1;
+        }
+        insertEntry(s->constantTable, s->constantTableCapacity, hashConstant(s->constants[i]), i + 1);
+        s->constantCount++;
+    }
+
+    //Nodes are packed one after another, so walk the code buffer from the start
+    int nodeCount = s->nodeCount;
+    int id = 0;
+    s->nodeCount = 0;
+    while(s->nodeCount < nodeCount) {
+        if(growTable(s, &s->nodeTable, &s->nodeTableCapacity, s->nodeCount, nodeKey)) {
+            return 1;
+        }
+        insertEntry(s->nodeTable, s->nodeTableCapacity, nodeKey(s, id), id + 1);
+        s->nodeCount++;
+
+        const unsigned char* code = s->code + id;
+        char op = (char)*code++;
+        readVarint(&code);
+        if(op != NUMBER_TOKEN && !isUnary(op) && op != 'm') {
+            readVarint(&code);
+        }
+        id = code - s->code;
+    }
+    return 0;
+}
+
+/*
+Finds a constant in the constant pool, adding it if it is not already there
+Returns the index of the constant, or -1 if memory allocation failed
+*/
+static int internConstant(ExpressionStore* s, double value) {
+    if(rebuildTables(s) || growTable(s, &s->constantTable, &s->constantTableCapacity, s->constantCount, constantKey)) {
+        return -1;
+    }
+    unsigned int slot = hashConstant(value) & (s->constantTableCapacity - 1);
+    while(s->constantTable[slot] != 0) {
+        int index = s->constantTable[slot] - 1;
+        if(memcmp(&s->constants[index], &value, sizeof(double)) == 0) {//Compare the bits so that 0 and -0 stay separate
+            return index;
+        }
+        slot = (slot + 1) & (s->constantTableCapacity - 1);
+    }
+
+    if(reserve((void**)&s->constants, &s->constantCapacity, s->constantCount, sizeof(double))) {
+        return -1;
+    }
+    s->constants[s->constantCount] = value;
+    s->constantTable[slot] = ++s->constantCount;
+    return s->constantCount - 1;
+}
+
+/*
+Finds a node in the store, adding it if an identical node does not exist yet (hash-consing)
+Returns the id of the node, or -1 if memory allocation failed
+*/
+static int internNode(ExpressionStore* s, char op, int a, int b) {
+    if(rebuildTables(s) || growTable(s, &s->nodeTable, &s->nodeTableCapacity, s->nodeCount, nodeKey)) {
+        return -1;
+    }
+    unsigned int slot = hashNode(op, a, b) & (s->nodeTableCapacity - 1);
+    while(s->nodeTable[slot] != 0) {
+        int id = s->nodeTable[slot] - 1;
+        int nodeA, nodeB;
+        if(decodeNode(s, id, &nodeA, &nodeB) == op && nodeA == a && nodeB == b) {
+            return id;
+        }
+        slot = (slot + 1) & (s->nodeTableCapacity - 1);
+    }
+
+    if(reserve((void**)&s->code, &s->codeCapacity, s->codeLength, sizeof(unsigned char))) {
+        return -1;
+    }
+    int id = s->codeLength;
+    if(markNodeStart(s, id)) {
+        return -1;
+    }
+    s->code[s->codeLength++] = (unsigned char)op;
+    //Operands are always stored before the node that uses them, so the distance back to them is small and positive
+    if(op == NUMBER_TOKEN ? writeVarint(s, (unsigned int)a) : (writeOperand(s, id, a) || (b != -1 && writeOperand(s, id, b)))) {
+        return -1;
+    }
+    s->nodeCount++;
+    s->nodeTable[slot] = id + 1;
+    return id;
+}
+
+/*
+Compiles an expression and adds it to the store. Identical expressions and shared subexpressions are only stored once.
+Returns the handle of the expression, or INVALID_HANDLE if the expression was invalid
+*/
+int storeExpression(ExpressionStore* s, char* exp) {
+    Postfix postfix;
+    initPostfix(&postfix);
+    if(compileExpression(exp, &postfix)) {
+        freePostfix(&postfix);
+        return INVALID_HANDLE;
+    }
+
+    //Stores the node id of each operand that has not been used by an operator yet
+    int* nodes = (int *)malloc(postfix.length * sizeof(int));
+    int top = -1;
+    int handle = INVALID_HANDLE;
+    if(nodes == NULL) {
+        printf("Memory allocation failed.\n");
+        freePostfix(&postfix);
+        return INVALID_HANDLE;
+    }
+
+    for(int i = 0; i < postfix.length; i++) {
+        char op = postfix.tokens[i].op;
+        int id;
+        if(op == NUMBER_TOKEN) {
+            int packed = packNumber(postfix.tokens[i].value);
+            if(packed != -1) {
+                nodes[++top] = INLINE_OPERAND(packed);
+                continue;
+            }
+            int index = internConstant(s, postfix.tokens[i].value);
+            id = index == -1 ? -1 : internNode(s, op, index, -1);
+        } else if(isUnary(op) || op == 'm') {
+            id = internNode(s, op, nodes[top--], -1);
+        } else {
+            int b = nodes[top--];
+            int a = nodes[top--];
+            id = internNode(s, op, a, b);
+        }
+        if(id == -1) {
+            top = -1;
+            break;
+        }
+        nodes[++top] = id;
+    }
+    if(top == 0 && IS_INLINE(nodes[0])) {
+        //An expression that is just a number still needs a node for its handle
+        int index = internConstant(s, unpackNumber(nodes[0]));
+        nodes[0] = index == -1 ? -1 : internNode(s, NUMBER_TOKEN, index, -1);
+    }
+    if(top == 0 && nodes[0] != -1) {
+        handle = nodes[0];
+    }
+
+    free(nodes);
+    freePostfix(&postfix);
+    return handle;
+}
+
+/*
+Evaluates a stored expression by its handle. Nodes are visited with an explicit stack so that very long expressions
+can't overflow the call stack.
+Returns a double of the expression result
+Returns NAN if an error has occurred or the handle is invalid
+*/
+double evaluateHandle(ExpressionStore* s, int handle) {
+    if(!isNodeStart(s, handle)) {
+        printf("Error: Invalid expression handle.\n");
+        return NAN;
+    }
+
+    int* work = NULL; //Node ids still to visit. The lowest bit is set once the node's operands have been visited.
+    int workTop = -1;
+    int workCapacity = 0;
+    double* values = NULL; //Results of the visited nodes
+    int valueTop = -1;
+    int valueCapacity = 0;
+    double result = NAN;
+
+    if(reserve((void**)&work, &workCapacity, 0, sizeof(int))) {
+        return NAN;
+    }
+    work[++workTop] = handle << 1;
+
+    while(workTop >= 0) {
+        int entry = work[workTop--];
+        int id = entry >> 1;
+        int a, b;
+        char op = decodeNode(s, id, &a, &b);
+
+        if(op != NUMBER_TOKEN && !(entry & 1)) {
+            //Visit the operand nodes first, then come back to this node. The left operand is on top so it is evaluated first.
+            if(reserve((void**)&work, &workCapacity, workTop + 3, sizeof(int))) {
+                break;
+            }
+            work[++workTop] = entry | 1;
+            if(b >= 0) {
+                work[++workTop] = b << 1;
+            }
+            if(a >= 0) {
+                work[++workTop] = a << 1;
+            }
+            continue;
+        }
+
+        double value;
+        if(op == NUMBER_TOKEN) {
+            value = s->constants[a];
+        } else {
+            double right = 0;
+            if(b != -1) {
+                right = IS_INLINE(b) ? unpackNumber(b) : values[valueTop--];
+            }
+            double left = IS_INLINE(a) ? unpackNumber(a) : values[valueTop--];
+            value = evaluateOp(op, left, right);
+        }
+        if(isnan(value)) {
+            printf("Error: Invalid operation.\n");
+            valueTop = -1;
+            break;
+        }
+        if(reserve((void**)&values, &valueCapacity, valueTop + 1, sizeof(double))) {
+            valueTop = -1;
+            break;
+        }
+        values[++valueTop] = value;
+    }
+
+    if(workTop < 0 && valueTop == 0) {
+        result = values[0];
+    }
+    free(work);
+    free(values);
+    return result;
+}
+
+/*
+Frees the hash tables and unused capacity once all expressions have been added, leaving only the packed code and the constant pool.
+Stored expressions can still be evaluated. Adding another expression rebuilds the hash tables first.
+*/
+void sealStore(ExpressionStore* s) {
+    free(s->nodeTable);
+    free(s->constantTable);
+    s->nodeTable = NULL;
+    s->constantTable = NULL;
+    s->nodeTableCapacity = 0;
+    s->constantTableCapacity = 0;
+
+    //Shrinking with realloc can't fail in a way that loses data, so keep the old buffer if it does
+    if(s->codeLength > 0) {
+        unsigned char* code = (unsigned char *)realloc(s->code, s->codeLength * sizeof(unsigned char));
+        if(code != NULL) {
+            s->code = code;
+            s->codeCapacity = s->codeLength;
+        }
+        int startsLength = (s->codeLength + 7) >> 3;
+        unsigned char* nodeStarts = (unsigned char *)realloc(s->nodeStarts, startsLength * sizeof(unsigned char));
+        if(nodeStarts != NULL) {
+            s->nodeStarts = nodeStarts;
+            s->nodeStartsCapacity = startsLength;
+        }
+    }
+    if(s->constantCount > 0) {
+        double* constants = (double *)realloc(s->constants, s->constantCount * sizeof(double));
+        if(constants != NULL) {
+            s->constants = constants;
+            s->constantCapacity = s->constantCount;
+        }
+    }
+}
+
+/*
+Returns the number of bytes of memory used by the store, including unused capacity
+*/
+size_t storeMemory(ExpressionStore* s) {
+    return s->codeCapacity * sizeof(unsigned char) +
+        s->nodeStartsCapacity * sizeof(unsigned char) +
+        s->nodeTableCapacity * sizeof(int) +
+        s->constantCapacity * sizeof(double) +
+        s->constantTableCapacity * sizeof(int);
+}
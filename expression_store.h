@@ -0,0 +1,52 @@
+#ifndef expression_store_h
+#define expression_store_h
+
+#include <stddef.h>
+
+#define INVALID_HANDLE -1 //The handle returned when an expression could not be stored
+#define MAX_INLINE_DECIMALS 3 //The most decimal places a number can have and still be stored inline. The count is packed into 2 bits.
+#define MAX_INLINE_MANTISSA (1 << 26) //Inline numbers are smaller than this once the decimal point is removed
+
+/*
+Stores a large number of compiled expressions in a compact, shared form.
+Every distinct subexpression is stored once as a node, so expressions that share subtrees also share their memory.
+A node is identified by its position in the code buffer, where it is packed as a 1-byte opcode (the same symbols used by evaluateOp) followed by varints:
+    NUMBER_TOKEN: the index of the number in the shared constant pool
+    unary operator: the operand
+    binary operator: the left operand, then the right operand
+An operand is either the number of bytes back to its node, shifted left by 1, or a number stored inline as (m*4 + k) << 1 | 1,
+where the number is exactly m / 10^k with k <= MAX_INLINE_DECIMALS. Numbers like 2 or 13.75 are kept in the node that uses them,
+while other numbers get a NUMBER_TOKEN node.
+An expression handle is the position of its root node. nodeStarts records which positions start a node, so a handle that doesn't is rejected.
+Measured size of a sealed store compared to the source strings:
+    1,500 expressions from expression_generator.py: 87% (1.15x smaller), because random expressions share few subtrees
+    200,000 expressions from 5 short arithmetic templates with random numbers: 79% (1.27x smaller)
+    200,000 expressions built from one template with varying numbers: 14% (7.3x smaller)
+*/
+typedef struct{
+    unsigned char* code; //The packed nodes
+    int codeLength;
+    int codeCapacity;
+    unsigned char* nodeStarts; //Bit x is set if a node starts at position x of the code buffer
+    int nodeStartsCapacity; //In bytes
+
+    int nodeCount;
+    int* nodeTable; //Hash table of node positions + 1 used to find existing nodes (0 is an empty slot)
+    int nodeTableCapacity;
+
+    double* constants; //The deduplicated constant pool
+    int constantCount;
+    int constantCapacity;
+
+    int* constantTable; //Hash table of constant indexes + 1 used to find existing constants (0 is an empty slot)
+    int constantTableCapacity;
+} ExpressionStore;
+
+void initStore(ExpressionStore* s);
+void freeStore(ExpressionStore* s);
+int storeExpression(ExpressionStore* s, char* exp);
+double evaluateHandle(ExpressionStore* s, int handle);
+void sealStore(ExpressionStore* s);
+size_t storeMemory(ExpressionStore* s);
+
+#endif
@@ -0,0 +1,427 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <float.h>
+#include <fenv.h>
+#include <math.h>
+#include "stack.h"
+#include "postfix.h"
+#include "deferred_eval.h"
+#include "float_batch.h"
+
+/*
+Batch evaluation in single precision, with a double precision fallback for every result that can't be trusted.
+Expressions that have the same operators in the same order (only their numbers differ) are evaluated together, up to FLOAT_BLOCK at a time.
+Each operation is a plain loop over the whole block, so the compiler turns it into vector instructions (compile with -O3 and -march for the target).
+A vector register holds twice as many floats as doubles, so each instruction does twice as much work as it would in double precision.
+Alongside each float value, every lane keeps an upper bound on how far that value can be from the exact result.
+A result is only kept if every number within its error bound rounds to the same value at the requested accuracy.
+Otherwise the expression is evaluated again in double precision with evaluateBatchDeferred, which gives the same result as evaluatePostfix.
+Only +, -, *, /, unary minus and integer powers are evaluated in single precision.
+Expressions that use any other operator are always evaluated in double precision.
+*/
+
+#define UNIT_ROUNDOFF (FLT_EPSILON / 2) //The largest relative error of one correctly rounded float operation
+#define BOUND_SLACK (1.0f + 1.0f/65536) //Covers the rounding of the error bounds themselves, and the error of the double precision result
+#define ABSOLUTE_ERROR FLT_MIN //More than the error of an operation whose result is too small to be a normal float. FLT_TRUE_MIN would be exact, but adding a subnormal number is very slow on many CPUs.
+
+// The operand stack of a block. Slot x of the stack holds FLOAT_BLOCK values, one for each expression, and the bound on the error of each value.
+typedef struct{
+    float values[MAX][FLOAT_BLOCK];
+    float errors[MAX][FLOAT_BLOCK];
+} BlockStack;
+
+/*
+Hashes the operators of an expression (FNV-1a). Integer powers include their exponent, because every lane has to use the same exponent.
+*/
+static unsigned int operatorSignature(Postfix* p) {
+    unsigned int hash = 2166136261u;
+    for(int i = 0; i < p->length; i++) {
+        hash = (hash ^ (unsigned char)p->tokens[i].op) * 16777619u;
+        if(p->tokens[i].op == INTEGER_POWER_TOKEN) {
+            hash = (hash ^ (unsigned int)(int)p->tokens[i].value) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+/*
+Checks if two expressions have the same operators in the same order, so they can be evaluated in the same block
+*/
+static bool sameOperators(Postfix* a, Postfix* b) {
+    if(a->length != b->length) {
+        return false;
+    }
+    for(int i = 0; i < a->length; i++) {
+        if(a->tokens[i].op != b->tokens[i].op) {
+            return false;
+        }
+        if(a->tokens[i].op == INTEGER_POWER_TOKEN && a->tokens[i].value != b->tokens[i].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+Puts the entries in order of their signatures, so that expressions that can share a block end up next to each other.
+Expressions with the same signature stay in their original order.
+This is a counting sort on a hash table of the distinct signatures, so it takes linear time.
+sorted: Must have room for count entries
+Returns 0 if successful, returns 1 if memory allocation failed
+*/
+static int groupBySignature(BatchEntry* entries, int count, BatchEntry* sorted) {
+    int tableSize = 1;
+    while(tableSize < 2 * count) {
+        tableSize *= 2;
+    }
+    int* table = (int *)malloc(tableSize * sizeof(int)); //The first entry with each signature, or -1 for an empty slot
+    int* groups = (int *)malloc(count * sizeof(int)); //The group of each entry
+    int* groupStarts = (int *)calloc(count + 1, sizeof(int)); //The number of entries in each group, then where each group starts
+    if(table == NULL || groups == NULL || groupStarts == NULL) {
+        free(table);
+        free(groups);
+        free(groupStarts);
+        return 1;
+    }
+    for(int slot = 0; slot < tableSize; slot++) {
+        table[slot] = -1;
+    }
+
+    int numGroups = 0;
+    for(int i = 0; i < count; i++) {
+        int slot = entries[i].signature & (tableSize - 1);
+        while(table[slot] != -1 && entries[table[slot]].signature != entries[i].signature) {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        if(table[slot] == -1) {
+            table[slot] = i;
+            groups[i] = numGroups++;
+        } else {
+            groups[i] = groups[table[slot]];
+        }
+        groupStarts[groups[i] + 1]++;
+    }
+
+    for(int group = 0; group < numGroups; group++) {
+        groupStarts[group + 1] += groupStarts[group];
+    }
+    for(int i = 0; i < count; i++) {
+        sorted[groupStarts[groups[i]]++] = entries[i];
+    }
+
+    free(table);
+    free(groups);
+    free(groupStarts);
+    return 0;
+}
+
+/*
+Checks if every operator of an expression can be evaluated in single precision with a known error bound, and that it fits on the stack
+*/
+static bool canUseFloat(Postfix* p) {
+    int depth = 0;
+    for(int i = 0; i < p->length; i++) {
+        char op = p->tokens[i].op;
+        if(op != NUMBER_TOKEN && op != '+' && op != '-' && op != '*' && op != '/' && op != 'm' && op != INTEGER_POWER_TOKEN) {
+            return false;
+        }
+        if(op == INTEGER_POWER_TOKEN && depth >= MAX) {//An integer power needs a free stack slot to build the power in
+            return false;
+        }
+        depth += 1 - operandCount(op);
+        if(depth > MAX || depth < 1) {
+            return false;
+        }
+    }
+    return depth == 1;
+}
+
+/*
+Adds or subtracts two stack slots and bounds the error of the results. a is replaced by the results.
+The errors of the inputs add up, plus the rounding of the result.
+*/
+static void addLanes(float* a, float* ea, float* b, float* eb, int n, bool subtract) {
+    float sign = subtract ? -1.0f : 1.0f;
+    for(int lane = 0; lane < n; lane++) {
+        a[lane] = a[lane] + sign*b[lane];
+        ea[lane] = (ea[lane] + eb[lane] + fabsf(a[lane])*UNIT_ROUNDOFF) * BOUND_SLACK + ABSOLUTE_ERROR;
+    }
+}
+
+/*
+Multiplies two stack slots and bounds the error of the products. a is replaced by the products.
+The exact inputs are within ea and eb of a and b, so the exact product is within |a|eb + |b|ea + ea*eb of a*b, plus the rounding of a*b.
+*/
+static void multiplyLanes(float* a, float* ea, float* b, float* eb, int n) {
+    for(int lane = 0; lane < n; lane++) {
+        float product = a[lane] * b[lane];
+        ea[lane] = (fabsf(a[lane])*eb[lane] + fabsf(b[lane])*ea[lane] + ea[lane]*eb[lane] + fabsf(product)*UNIT_ROUNDOFF) * BOUND_SLACK + ABSOLUTE_ERROR;
+        a[lane] = product;
+    }
+}
+
+/*
+Divides two stack slots and bounds the error of the quotients. a is replaced by the quotients.
+The exact quotient is within (|a|eb + |b|ea) / (|b|(|b| - eb)) of a/b, plus the rounding of a/b.
+If a divisor could be 0 (|b| <= eb), the lane is set to NAN so that it is evaluated again in double precision.
+*/
+static void divideLanes(float* a, float* ea, float* b, float* eb, int n) {
+    for(int lane = 0; lane < n; lane++) {
+        float divisor = fabsf(b[lane]);
+        float quotient = a[lane] / b[lane]; //Always divided, even by 0, so that the loop has no branches
+        quotient = divisor > eb[lane] ? quotient : NAN;
+        ea[lane] = ((fabsf(a[lane])*eb[lane] + divisor*ea[lane]) / (divisor*(divisor - eb[lane])) + fabsf(quotient)*UNIT_ROUNDOFF) * BOUND_SLACK + ABSOLUTE_ERROR;
+        a[lane] = quotient;
+    }
+}
+
+/*
+Squares a stack slot and bounds the error of the squares, the same as multiplyLanes(a, ea, a, ea, n)
+*/
+static void squareLanes(float* a, float* ea, int n) {
+    for(int lane = 0; lane < n; lane++) {
+        float square = a[lane] * a[lane];
+        ea[lane] = (2*fabsf(a[lane])*ea[lane] + ea[lane]*ea[lane] + fabsf(square)*UNIT_ROUNDOFF) * BOUND_SLACK + ABSOLUTE_ERROR;
+        a[lane] = square;
+    }
+}
+
+/*
+Raises a stack slot to a whole number power with the same chain of multiplications as evaluateOp
+result, resultErrors: An unused stack slot to build the power in
+*/
+static void integerPowerLanes(float* a, float* ea, float* result, float* resultErrors, int n, int exponent) {
+    for(int lane = 0; lane < n; lane++) {
+        result[lane] = 1;
+        resultErrors[lane] = 0;
+    }
+    for(int bits = abs(exponent); bits > 0; bits >>= 1) {
+        if(bits & 1) {
+            multiplyLanes(result, resultErrors, a, ea, n);
+        }
+        squareLanes(a, ea, n);
+    }
+    if(exponent < 0) {
+        for(int lane = 0; lane < n; lane++) {
+            a[lane] = 1;
+            ea[lane] = 0;
+        }
+        divideLanes(a, ea, result, resultErrors, n);
+    } else {
+        for(int lane = 0; lane < n; lane++) {
+            a[lane] = result[lane];
+            ea[lane] = resultErrors[lane];
+        }
+    }
+}
+
+/*
+Evaluates a block of up to FLOAT_BLOCK expressions with identical operators in single precision
+entries: The expressions of the block
+stack: Set so that values[0] holds the result of each expression and errors[0] the bound on its error. A bound is NAN or infinity if there is no bound.
+*/
+static void evaluateBlock(BatchEntry* entries, int n, BlockStack* stack) {
+    Postfix* first = entries[0].expression;
+    int top = -1;
+
+    for(int i = 0; i < first->length; i++) {
+        char op = first->tokens[i].op;
+        switch(op) {
+            case NUMBER_TOKEN:
+                top++;
+                for(int lane = 0; lane < n; lane++) {
+                    stack->values[top][lane] = (float)entries[lane].expression->tokens[i].value;
+                }
+                for(int lane = 0; lane < n; lane++) {
+                    stack->errors[top][lane] = fabsf(stack->values[top][lane]) * UNIT_ROUNDOFF * BOUND_SLACK + ABSOLUTE_ERROR;
+                }
+                break;
+            case 'm':
+                for(int lane = 0; lane < n; lane++) {
+                    stack->values[top][lane] = -stack->values[top][lane];
+                }
+                break;
+            case INTEGER_POWER_TOKEN://canUseFloat made sure there is a free slot above the top of the stack
+                integerPowerLanes(stack->values[top], stack->errors[top], stack->values[top+1], stack->errors[top+1], n, (int)first->tokens[i].value);
+                break;
+            case '+':
+            case '-':
+                addLanes(stack->values[top-1], stack->errors[top-1], stack->values[top], stack->errors[top], n, op == '-');
+                top--;
+                break;
+            case '*':
+                multiplyLanes(stack->values[top-1], stack->errors[top-1], stack->values[top], stack->errors[top], n);
+                top--;
+                break;
+            case '/':
+                divideLanes(stack->values[top-1], stack->errors[top-1], stack->values[top], stack->errors[top], n);
+                top--;
+                break;
+        }
+    }
+}
+
+/*
+Rounds a value to a number of decimal places, the same way the test harness compares results
+*/
+static double roundToAccuracy(double value, double precisionFactor) {
+    return round(value * precisionFactor) / precisionFactor;
+}
+
+/*
+Sets up a batch of compiled expressions by grouping the ones that have the same operators.
+Call freeFloatBatch when the batch is no longer needed. The expressions must stay allocated until then.
+Returns 0 if successful, returns 1 if memory allocation failed
+*/
+int initFloatBatch(FloatBatch* batch, Postfix* expressions, int count) {
+    batch->expressions = expressions;
+    batch->count = count;
+    batch->numGroups = 0;
+    batch->entries = (BatchEntry *)malloc(count * sizeof(BatchEntry));
+    batch->groups = (BatchGroup *)malloc(count * sizeof(BatchGroup));
+    batch->stack = malloc(sizeof(BlockStack));
+    batch->needsDouble = (bool *)calloc(count, sizeof(bool));
+    batch->retries = (Postfix *)malloc(count * sizeof(Postfix));
+    batch->retryIndexes = (int *)malloc(count * sizeof(int));
+    BatchEntry* unsorted = (BatchEntry *)malloc(count * sizeof(BatchEntry));
+    if(batch->entries == NULL || batch->groups == NULL || batch->stack == NULL || batch->needsDouble == NULL ||
+        batch->retries == NULL || batch->retryIndexes == NULL || unsorted == NULL) {
+        free(unsorted);
+        freeFloatBatch(batch);
+        return 1;
+    }
+
+    for(int i = 0; i < count; i++) {
+        unsorted[i].expression = &expressions[i];
+        unsorted[i].index = i;
+        unsorted[i].signature = operatorSignature(&expressions[i]);
+    }
+    int failed = groupBySignature(unsorted, count, batch->entries);
+    free(unsorted);
+    if(failed) {
+        freeFloatBatch(batch);
+        return 1;
+    }
+
+    //Split each run of equal signatures into groups with the same operators. A run only holds more than one group if two signatures collide.
+    BatchEntry* entries = batch->entries;
+    int start = 0;
+    while(start < count) {
+        int end = start + 1;
+        while(end < count && entries[end].signature == entries[start].signature) {
+            end++;
+        }
+        while(start < end) {
+            int length = 1;
+            for(int i = start + 1; i < end; i++) {
+                if(sameOperators(entries[start].expression, entries[i].expression)) {
+                    BatchEntry match = entries[i];
+                    entries[i] = entries[start + length];
+                    entries[start + length] = match;
+                    length++;
+                }
+            }
+            BatchGroup* group = &batch->groups[batch->numGroups++];
+            group->start = start;
+            group->length = length;
+            group->useFloat = length >= MIN_FLOAT_BLOCK && canUseFloat(entries[start].expression);
+            start += length;
+        }
+    }
+    return 0;
+}
+
+/*
+Frees the memory used by a batch. The expressions themselves are not freed.
+*/
+void freeFloatBatch(FloatBatch* batch) {
+    free(batch->entries);
+    free(batch->groups);
+    free(batch->stack);
+    free(batch->needsDouble);
+    free(batch->retries);
+    free(batch->retryIndexes);
+    batch->entries = NULL;
+    batch->groups = NULL;
+    batch->stack = NULL;
+    batch->needsDouble = NULL;
+    batch->retries = NULL;
+    batch->retryIndexes = NULL;
+    batch->count = 0;
+    batch->numGroups = 0;
+}
+
+/*
+Evaluates every expression of a batch, in single precision wherever that gives the same answer.
+Every result rounds to the same value at accuracy decimal places as the result of evaluatePostfix, and errors still return NAN.
+Results that single precision can't guarantee are evaluated again in double precision.
+When more than MAX_FALLBACK_PERCENT of a block falls back, single precision can't meet the accuracy for numbers like these,
+so the rest of the group goes straight to double precision instead of being evaluated twice.
+accuracy: The number of decimal places the results must be correct to, like ACCURACY in test_calculator.c
+results: Must have room for the number of expressions in the batch. results[i] is set to the result of expression i, or NAN if an error has occurred.
+Returns the number of expressions that were evaluated in double precision
+*/
+int evaluateFloatBatch(FloatBatch* batch, int accuracy, double* results) {
+    BlockStack* stack = (BlockStack *)batch->stack;
+    double precisionFactor = pow(10.0, accuracy);
+
+    //Dividing by a divisor that might be 0 raises exceptions that are handled by falling back to double precision, so keep them from the caller
+    fexcept_t flags;
+    fegetexceptflag(&flags, FE_ALL_EXCEPT);
+
+    for(int g = 0; g < batch->numGroups; g++) {
+        BatchGroup* group = &batch->groups[g];
+        bool useFloat = group->useFloat; //Cleared for the rest of the group once a block falls back too often
+        for(int start = group->start; start < group->start + group->length; start += FLOAT_BLOCK) {
+            BatchEntry* entries = &batch->entries[start];
+            int n = group->start + group->length - start < FLOAT_BLOCK ? group->start + group->length - start : FLOAT_BLOCK;
+            if(!useFloat) {
+                for(int lane = 0; lane < n; lane++) {
+                    batch->needsDouble[entries[lane].index] = true;
+                }
+                continue;
+            }
+
+            evaluateBlock(entries, n, stack);
+            int numFallback = 0;
+            for(int lane = 0; lane < n; lane++) {
+                float value = stack->values[0][lane];
+                float error = stack->errors[0][lane];
+                //Every number within the error bound must round the same way, otherwise the float result might round differently than the exact one
+                if(isfinite(value) && isfinite(error) &&
+                    roundToAccuracy((double)value - error, precisionFactor) == roundToAccuracy((double)value + error, precisionFactor)) {
+                    results[entries[lane].index] = value;
+                } else {
+                    batch->needsDouble[entries[lane].index] = true;
+                    numFallback++;
+                }
+            }
+            useFloat = numFallback * 100 <= n * MAX_FALLBACK_PERCENT;
+        }
+    }
+
+    fesetexceptflag(&flags, FE_ALL_EXCEPT);
+
+    //Collect the expressions in their original order, which reads them from memory much faster than in group order.
+    //Only shallow copies are made, so the tokens are not copied.
+    int numDouble = 0;
+    for(int i = 0; i < batch->count; i++) {
+        if(batch->needsDouble[i]) {
+            batch->needsDouble[i] = false;
+            batch->retries[numDouble] = batch->expressions[i];
+            batch->retryIndexes[numDouble] = i;
+            numDouble++;
+        }
+    }
+
+    double retryResults[FLOAT_BLOCK];
+    for(int start = 0; start < numDouble; start += FLOAT_BLOCK) {
+        int n = numDouble - start < FLOAT_BLOCK ? numDouble - start : FLOAT_BLOCK;
+        evaluateBatchDeferred(&batch->retries[start], n, retryResults);
+        for(int i = 0; i < n; i++) {
+            results[batch->retryIndexes[start + i]] = retryResults[i];
+        }
+    }
+    return numDouble;
+}
@@ -0,0 +1,48 @@
+#ifndef float_batch_h
+#define float_batch_h
+
+#include <stdbool.h>
+#include "postfix.h"
+
+#define FLOAT_BLOCK 64 //The most expressions with the same operators that are evaluated together in one pass
+#define MIN_FLOAT_BLOCK 8 //Groups with fewer expressions than this are evaluated in double precision, because a pass over so few isn't worth it
+#define MAX_FALLBACK_PERCENT 50 //If more of a block than this falls back to double precision, the rest of its group skips single precision
+
+// An expression of a batch and its position in the batch, so that expressions can be grouped without moving them
+typedef struct{
+    Postfix* expression;
+    int index;
+    unsigned int signature; //A hash of the operators, so most different expressions can be told apart without comparing every token
+} BatchEntry;
+
+// A run of expressions in a batch that all have the same operators in the same order
+typedef struct{
+    int start; //The first entry of the group
+    int length;
+    bool useFloat; //False if the group is too small or uses an operator that can't be evaluated in single precision
+} BatchGroup;
+
+/*
+A batch of compiled expressions, grouped once so that it can be evaluated many times in single precision.
+The numbers in the expressions can be changed between evaluations, but the operators can't.
+It is only faster than evaluateBatchDeferred when most results can be kept in single precision. Measured with -O3 -march=native
+on 200,000 expressions from 5 templates, it is 1.7x faster at accuracy 1, about as fast at accuracy 2, and 10-30% slower at accuracy 3
+or more, where most results are evaluated again in double precision. Use evaluateBatchDeferred at accuracy 3 or more.
+*/
+typedef struct{
+    Postfix* expressions; //The expressions in their original order
+    BatchEntry* entries; //The expressions, in order of their groups
+    int count;
+    BatchGroup* groups;
+    int numGroups;
+    void* stack; //The operand stack of one block, allocated once for every evaluation
+    bool* needsDouble; //needsDouble[i] is set while evaluating if expression i has to be evaluated in double precision
+    Postfix* retries; //The expressions that have to be evaluated in double precision, in their original order so they can be evaluated together
+    int* retryIndexes; //The position in the batch of each expression in retries
+} FloatBatch;
+
+int initFloatBatch(FloatBatch* batch, Postfix* expressions, int count);
+void freeFloatBatch(FloatBatch* batch);
+int evaluateFloatBatch(FloatBatch* batch, int accuracy, double* results);
+
+#endif
@@ -0,0 +1,34 @@
+#!/bin/bash
+
+# Builds the fuzz targets. Run from the fuzz directory.
+#   fuzz_calculator      libFuzzer target with AddressSanitizer and UndefinedBehaviorSanitizer
+#   fuzz_differential    the same, and it also compares every result with reference_evaluator.c
+#   afl_calculator       AFL++ persistent mode target (only built if afl-clang-fast is installed)
+#
+# Run with:
+#   ./fuzz_differential -dict=calculator.dict -max_len=256 corpus/
+
+sources="fuzz_calculator.c reference_evaluator.c ../calculator.c ../stack.c ../validator.c ../budget.c"
+flags="-g -O1 -fno-omit-frame-pointer"
+
+(cd .. && python3 validator_generator.py)
+python3 make_dictionary.py
+
+clang $flags -fsanitize=fuzzer,address,undefined $sources -o fuzz_calculator -lm
+if [ $? -ne 0 ]; then
+    echo "fuzz_calculator compilation failed."
+    exit 1
+fi
+
+clang $flags -fsanitize=fuzzer,address,undefined -DFUZZ_DIFFERENTIAL $sources -o fuzz_differential -lm
+if [ $? -ne 0 ]; then
+    echo "fuzz_differential compilation failed."
+    exit 1
+fi
+
+if command -v afl-clang-fast > /dev/null; then
+    AFL_USE_ASAN=1 afl-clang-fast $flags -DFUZZ_STANDALONE -DFUZZ_DIFFERENTIAL $sources -o afl_calculator -lm
+    echo "Run AFL++ with: afl-fuzz -i corpus -o findings -x calculator.dict -- ./afl_calculator"
+fi
+
+echo "Fuzz targets compiled successfully."
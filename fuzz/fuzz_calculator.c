@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "../calculator.h"
+#include "../stack.h"
+#include "../validator.h"
+#include "reference_evaluator.h"
+
+/*
+In-process fuzz target for the parser and evaluator. Build it with build_fuzzers.sh.
+Every input is run through validateExpression, evaluateExpression, findNumber and findOperator.
+Memory errors and undefined behaviour are caught by the sanitizers the target is built with.
+When FUZZ_DIFFERENTIAL is defined, the result of evaluateExpression is also compared with reference_evaluator.c,
+and the target aborts if they disagree so the fuzzer saves the input.
+When FUZZ_STANDALONE is defined, a main function is included so the target can be run on files without libFuzzer (for example with AFL++ or gcc).
+Built with afl-clang-fast, that main function uses AFL++ persistent mode and runs many inputs in one process instead of forking for each one.
+*/
+
+#define MAX_INPUT_LENGTH 4096 //Longer inputs only repeat what shorter inputs already cover
+#define AFL_LOOP_COUNT 100000 //The number of inputs AFL++ runs in one process before starting a fresh one
+
+/*
+Sends the error messages the evaluator prints to /dev/null so they don't slow down the fuzzer
+*/
+int LLVMFuzzerInitialize(int* argc, char*** argv) {
+    (void)argc;
+    (void)argv;
+    if(freopen("/dev/null", "w", stdout) == NULL) {
+        fprintf(stderr, "Warning: could not redirect stdout.\n");
+    }
+    return 0;
+}
+
+/*
+Calls findNumber and findOperator directly at every position where the evaluator could call them,
+so inputs that evaluateExpression or the validator would reject early still reach them
+*/
+static void fuzzTokenizers(char* exp) {
+    for(int start = 0; exp[start] != '\0'; start++) {
+        int i = start;
+        if(isNumber(exp[start])) {
+            findNumber(exp, &i);
+        } else if(isOperator(exp[start])) {
+            findOperator(exp, &i);
+        }
+        if(i < start || i > start + (int)strlen(exp + start)) {
+            fprintf(stderr, "Tokenizer moved outside of the expression at index %d.\n", start);
+            abort();
+        }
+    }
+}
+
+#ifdef FUZZ_DIFFERENTIAL
+/*
+Aborts if evaluateExpression and the reference evaluator disagree about an expression
+*/
+static void compareWithReference(char* exp, double result) {
+    bool valid;
+    double expected = referenceEvaluate(exp, &valid);
+    bool failed = false;
+    if(!isnan(result) && !valid) {
+        failed = true; //The evaluator accepted an expression the grammar doesn't allow
+    } else if(!isnan(result) && result != expected) {
+        failed = true; //Both accepted it but the results differ
+    } else if(isnan(result) && valid && (int)strlen(exp) < MAX) {
+        //The evaluator rejected a valid expression.
+        //Expressions with at least MAX characters may need more than MAX stack slots, so those are allowed to be rejected.
+        failed = true;
+    }
+    if(failed) {
+        fprintf(stderr, "Mismatch for \"%s\": evaluator %.17g, reference %.17g (%s)\n",
+            exp, result, expected, valid ? "valid" : "invalid");
+        abort();
+    }
+}
+#endif
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    //The evaluator works on null-terminated strings, so stop at the first null byte
+    size_t length = 0;
+    while(length < size && length < MAX_INPUT_LENGTH && data[length] != '\0') {
+        length++;
+    }
+    char* exp = malloc(length + 1);
+    if(exp == NULL) {
+        return 0;
+    }
+    memcpy(exp, data, length);
+    exp[length] = '\0';
+
+    validateExpression(exp);
+    fuzzTokenizers(exp);
+    double result = evaluateExpression(&exp);
+#ifdef FUZZ_DIFFERENTIAL
+    compareWithReference(exp, result);
+#else
+    (void)result;
+#endif
+
+    free(exp);
+    return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+#ifdef __AFL_HAVE_MANUAL_CONTROL
+__AFL_FUZZ_INIT();
+#endif
+
+/*
+Runs the target once on each file given on the command line, or once on stdin if there are none
+*/
+static int runFile(FILE* file) {
+    uint8_t buffer[MAX_INPUT_LENGTH];
+    size_t size = fread(buffer, 1, sizeof(buffer), file);
+    return LLVMFuzzerTestOneInput(buffer, size);
+}
+
+int main(int argc, char** argv) {
+    LLVMFuzzerInitialize(&argc, &argv);
+    if(argc < 2) {
+#ifdef __AFL_HAVE_MANUAL_CONTROL
+        //AFL++ passes each input through shared memory, so the buffer must only be read after __AFL_INIT
+        __AFL_INIT();
+        unsigned char* buffer = __AFL_FUZZ_TESTCASE_BUF;
+        while(__AFL_LOOP(AFL_LOOP_COUNT)) {
+            LLVMFuzzerTestOneInput(buffer, __AFL_FUZZ_TESTCASE_LEN);
+        }
+        return 0;
+#else
+        return runFile(stdin);
+#endif
+    }
+    for(int arg = 1; arg < argc; arg++) {
+        FILE* file = fopen(argv[arg], "rb");
+        if(file == NULL) {
+            fprintf(stderr, "Error: could not open %s\n", argv[arg]);
+            return 1;
+        }
+        runFile(file);
+        fclose(file);
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,47 @@
+import csv
+
+############### Generates calculator.dict for the fuzzers from char_matrix.csv ###############
+# The dictionary gives the fuzzer every token of the expression language, so it doesn't have to guess function names one byte at a time.
+# Run "python3 make_dictionary.py" from the fuzz directory whenever char_matrix.csv changes. build_fuzzers.sh does this automatically.
+
+CHAR_FILENAME = "../char_matrix.csv"
+DICT_FILENAME = "calculator.dict"
+
+# The full names of the functions, keyed by the character that starts them in the matrix
+FUNCTION_NAMES = {
+    's': ["sin"],
+    'c': ["cos", "cot"],
+    't': ["tan"],
+    'o': [], # 'o' is the evaluator's symbol for cot, which is already written as "cot"
+    'l': ["log", "ln"],
+    'n': [],
+}
+
+# Sequences that reach the evaluator's edge cases
+EXTRA_TOKENS = ["--", "-.", "()", "{}", ")(", "}{", "999999999999999", "0.000000000000001"]
+
+# Escapes a token so that it can be written in a libFuzzer/AFL dictionary
+# @param token The token to escape
+# @return The quoted dictionary entry
+def quote(token):
+    return '"' + token.replace('\\', '\\\\').replace('"', '\\"') + '"'
+
+with open(CHAR_FILENAME, mode='r', newline='', encoding='utf-8-sig') as file:
+    header = next(csv.reader(file))
+tokens = header[1:int(header[0])+1]
+
+entries = []
+for token in tokens:
+    if token in FUNCTION_NAMES:
+        for name in FUNCTION_NAMES[token]:
+            entries.extend([name, name + "("])
+    else:
+        entries.append(token)
+entries.extend(EXTRA_TOKENS)
+
+with open(DICT_FILENAME, mode='w', newline='\n') as file:
+    file.write("# This file is generated by make_dictionary.py from " + CHAR_FILENAME + ". Do not edit it by hand.\n")
+    for index, entry in enumerate(entries):
+        file.write("token_%d=%s\n" % (index, quote(entry)))
+
+print(DICT_FILENAME, "successfully written.")
@@ -0,0 +1,176 @@
+#include <stdbool.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include "reference_evaluator.h"
+
+/*
+An independent recursive-descent evaluator used as the oracle for the differential fuzz target.
+It shares no code with calculator.c. It implements the same language from its grammar:
+    expression := term (('+' | '-') term)*
+    term       := power (('*' | '/') power)*
+    power      := unary ('^' unary)*                           (left-associative, like the shunting-yard loop)
+    unary      := '-' atom | atom                              (unary minus binds tighter than ^, so -2^2 is 4)
+    atom       := function (number | '(' expression ')') | number | '(' expression ')' | '{' expression '}'
+A binary operator can't be followed by '.', and numbers have at most 15 significant digits and are accumulated digit by digit like findNumber.
+Any operation that is undefined or overflows makes the whole expression invalid.
+*/
+
+// The state of the parser
+typedef struct{
+    const char* exp;
+    int i;
+    bool valid;
+} Parser;
+
+static double parseExpression(Parser* p);
+
+/*
+Marks the expression invalid if a result is not a finite number
+*/
+static double check(Parser* p, double value) {
+    if(!isfinite(value)) {
+        p->valid = false;
+        return 0;
+    }
+    return value;
+}
+
+static double parseNumber(Parser* p) {
+    double value = 0;
+    double place = 1;
+    int digits = 0;
+    bool fraction = false;
+    while(p->exp[p->i] == '.' || (p->exp[p->i] >= '0' && p->exp[p->i] <= '9')) {
+        char ch = p->exp[p->i++];
+        if(ch == '.') {
+            //Only one period, and it must be followed by a digit
+            if(fraction || !(p->exp[p->i] >= '0' && p->exp[p->i] <= '9')) {
+                p->valid = false;
+                return 0;
+            }
+            fraction = true;
+        } else if(++digits > 15) {
+            p->valid = false;
+            return 0;
+        } else if(fraction) {
+            place *= 10;
+            value += (ch - '0') / place;
+        } else {
+            value = value * 10 + (ch - '0');
+        }
+    }
+    if(digits == 0) {
+        p->valid = false;
+    }
+    return value;
+}
+
+/*
+Parses a bracketed expression starting at the opening bracket
+*/
+static double parseBrackets(Parser* p) {
+    char close = p->exp[p->i] == '(' ? ')' : '}';
+    p->i++;
+    double value = parseExpression(p);
+    if(p->exp[p->i] != close) {
+        p->valid = false;
+        return 0;
+    }
+    p->i++;
+    return value;
+}
+
+static double parseAtom(Parser* p) {
+    const char* names[] = {"sin", "cos", "tan", "cot", "log", "ln"};
+    const char* rest = p->exp + p->i;
+    for(int f = 0; f < 6; f++) {
+        int length = strlen(names[f]);
+        if(strncmp(rest, names[f], length) != 0) {
+            continue;
+        }
+        p->i += length;
+        double x;
+        if(p->exp[p->i] == '(') {
+            x = parseBrackets(p);
+        } else if(p->exp[p->i] >= '0' && p->exp[p->i] <= '9') {
+            x = parseNumber(p);
+        } else {
+            p->valid = false;
+            return 0;
+        }
+        switch(f) {
+            case 0: return check(p, sin(x));
+            case 1: return check(p, cos(x));
+            case 2: return check(p, tan(x));
+            case 3: return check(p, tan(x) == 0 ? NAN : 1.0/tan(x));
+            case 4: return check(p, x > 0 ? log10(x) : NAN);
+            default: return check(p, x > 0 ? log(x) : NAN);
+        }
+    }
+    if(*rest == '(' || *rest == '{') {
+        return parseBrackets(p);
+    }
+    return parseNumber(p);
+}
+
+static double parseUnary(Parser* p) {
+    if(p->exp[p->i] == '-') {
+        p->i++;
+        return -parseAtom(p);
+    }
+    return parseAtom(p);
+}
+
+/*
+Moves past a binary operator, which can't be followed by a period
+*/
+static void skipOperator(Parser* p) {
+    p->i++;
+    if(p->exp[p->i] == '.') {
+        p->valid = false;
+    }
+}
+
+static double parsePower(Parser* p) {
+    double value = parseUnary(p);
+    while(p->valid && p->exp[p->i] == '^') {
+        skipOperator(p);
+        value = check(p, pow(value, parseUnary(p)));
+    }
+    return value;
+}
+
+static double parseTerm(Parser* p) {
+    double value = parsePower(p);
+    while(p->valid && (p->exp[p->i] == '*' || p->exp[p->i] == '/')) {
+        char op = p->exp[p->i];
+        skipOperator(p);
+        double right = parsePower(p);
+        value = check(p, op == '*' ? value * right : (right == 0 ? NAN : value / right));
+    }
+    return value;
+}
+
+static double parseExpression(Parser* p) {
+    double value = parseTerm(p);
+    while(p->valid && (p->exp[p->i] == '+' || p->exp[p->i] == '-')) {
+        char op = p->exp[p->i];
+        skipOperator(p);
+        double right = parseTerm(p);
+        value = check(p, op == '+' ? value + right : value - right);
+    }
+    return value;
+}
+
+/*
+Evaluates an expression with the reference grammar
+valid: Set to false if the expression is malformed or any operation is undefined or overflows
+Returns the result, or NAN if the expression is not valid
+*/
+double referenceEvaluate(const char* exp, bool* valid) {
+    Parser p = {exp, 0, true};
+    double value = parseExpression(&p);
+    *valid = p.valid && exp[p.i] == '\0';
+    return *valid ? value : NAN;
+}
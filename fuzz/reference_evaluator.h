@@ -0,0 +1,8 @@
+#ifndef reference_evaluator_h
+#define reference_evaluator_h
+
+#include <stdbool.h>
+
+double referenceEvaluate(const char* exp, bool* valid);
+
+#endif
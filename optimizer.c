@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include "calculator.h"
+#include "postfix.h"
+#include "optimizer.h"
+
+/*
+Checks if a*b can be computed without rounding and with |a*b| >= |a| and |a*b| >= |b|.
+Replacing (x*a)*b with x*(a*b) is only safe under these conditions: the product of the constants adds no rounding error,
+and x*(a*b) overflows exactly when (x*a)*b would have.
+*/
+static bool isExactProduct(double a, double b) {
+    double product = a * b;
+    return fabs(a) >= 1 && fabs(b) >= 1 && !isinf(product) && fma(a, b, -product) == 0;
+}
+
+/*
+Rewrites a compiled expression in place so that it evaluates with fewer and cheaper operations:
+    x^n, where n is a whole number with |n| <= MAX_INTEGER_POWER, becomes an INTEGER_POWER_TOKEN that uses a chain of multiplications instead of pow
+    a unary minus applied to a unary minus is removed, and a unary minus applied to a number is folded into the number
+    (x*a)*b and (x/a)/b, where a and b are numbers, become x*(a*b) and x/(a*b) when a*b is exact
+Accuracy: negation folding and constant fusion give the same result or a more accurate one, because a*b is exact and one rounding is removed.
+An integer power gives exactly the same result as pow. evaluateOp only keeps the chain of multiplications when it rounds at most once
+(x^0, x^1, x^2, x^-1, or a whole x whose power is an exact integer) and calls pow otherwise, because the rounding errors of a longer chain
+build up and change results after rounding to ACCURACY. Operations that would return NAN still return NAN.
+The optimized expression is meant for evaluatePostfix. Take gradients of the unoptimized expression, since folding changes which numbers are inputs.
+*/
+void optimizePostfix(Postfix* p) {
+    PostfixToken* out = p->tokens; //The optimized tokens are written over the original ones. They are never longer.
+    int length = 0;
+
+    for(int i = 0; i < p->length; i++) {
+        PostfixToken token = p->tokens[i];
+
+        //A unary operator applies to the value produced by the previous token, so if that token is a number it is the operand
+        bool afterNumber = length > 0 && out[length-1].op == NUMBER_TOKEN;
+
+        if(token.op == 'm' && length > 0 && out[length-1].op == 'm') {//-(-x) is x
+            length--;
+            continue;
+        }
+        if(token.op == 'm' && afterNumber) {//Fold -(a) into the number
+            out[length-1].value = -out[length-1].value;
+            continue;
+        }
+        if(token.op == '^' && afterNumber) {//x^n with a small whole number n
+            double exponent = out[length-1].value;
+            if(exponent == floor(exponent) && fabs(exponent) <= MAX_INTEGER_POWER) {
+                out[length-1].op = INTEGER_POWER_TOKEN;
+                continue;
+            }
+        }
+        //(x*a)*b or (x/a)/b: the output ends with a, the first operator, then b
+        if((token.op == '*' || token.op == '/') && afterNumber && length >= 3 &&
+            out[length-2].op == token.op && out[length-3].op == NUMBER_TOKEN &&
+            isExactProduct(out[length-3].value, out[length-1].value)) {
+                out[length-3].value *= out[length-1].value;
+                length--; //Drop b. The first operator now applies a*b.
+                continue;
+        }
+
+        out[length++] = token;
+    }
+    p->length = length;
+}
@@ -0,0 +1,10 @@
+#ifndef optimizer_h
+#define optimizer_h
+
+#include "postfix.h"
+
+#define MAX_INTEGER_POWER 16 //The largest whole-number exponent that is replaced by a chain of multiplications
+
+void optimizePostfix(Postfix* p);
+
+#endif
@@ -0,0 +1,322 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "calculator.h"
+#include "validator.h"
+#include "parallel_eval.h"
+
+// The part of a segment of the expression that is scanned by one thread
+typedef struct{
+    char* exp;
+    int segmentStart; //The first character of the whole segment
+    int lastIndex; //The last character of the whole segment, which is left out of minDepth
+    int start; //The first character scanned by this thread
+    int end; //One past the last character scanned by this thread
+
+    int depthChange; //Pass 1: the net change in bracket depth from start to end
+    int minDepth; //Pass 1: the lowest depth after any character before lastIndex, relative to the depth at start
+    int startDepth; //Pass 2: the bracket depth before start, found by a prefix scan of depthChange
+
+    int* additive; //Pass 2: positions of binary + and - at depth 0
+    int numAdditive;
+    int additiveCapacity;
+    int* multiplicative; //Pass 2: positions of * and / at depth 0
+    int numMultiplicative;
+    int multiplicativeCapacity;
+} ScanChunk;
+
+// The independent terms of a segment, shared by every thread that evaluates them
+typedef struct{
+    char* exp;
+    int segmentStart;
+    int segmentEnd;
+    int* splits; //Term i ends at splits[i], and the operator there joins it to term i+1
+    int numTerms;
+    double* results;
+    int nextTerm; //The next term that hasn't been taken by a thread
+    pthread_mutex_t lock;
+} TermQueue;
+
+static double evaluateSegment(char* exp, int start, int end, int numThreads);
+
+/*
+Runs work on numThreads threads, each with its own argument from args, and waits for all of them to finish (fork-join).
+The calling thread runs the first argument itself. If a thread can't be created, its work is run on the calling thread instead.
+*/
+static void runThreads(void* (*work)(void*), void* args, size_t argSize, int numThreads) {
+    pthread_t threads[MAX_THREADS];
+    bool started[MAX_THREADS];
+
+    for(int t = 1; t < numThreads; t++) {
+        started[t] = pthread_create(&threads[t], NULL, work, (char*)args + t * argSize) == 0;
+    }
+    work(args);
+    for(int t = 1; t < numThreads; t++) {
+        if(started[t]) {
+            pthread_join(threads[t], NULL);
+        } else {
+            work((char*)args + t * argSize);
+        }
+    }
+}
+
+/*
+Adds a position to the end of a dynamically-allocated array
+Returns 0 if successful, returns 1 if memory allocation failed
+*/
+static int appendPosition(int** items, int* length, int* capacity, int position) {
+    if(*length == *capacity) {
+        int newCapacity = *capacity == 0 ? INITIAL_CAPACITY : *capacity * 2;
+        int* newItems = (int *)realloc(*items, newCapacity * sizeof(int));
+        if(newItems == NULL) {
+            return 1;
+        }
+        *items = newItems;
+        *capacity = newCapacity;
+    }
+    (*items)[(*length)++] = position;
+    return 0;
+}
+
+/*
+Pass 1 of the bracket depth prefix scan: finds the net change in depth and the lowest depth over one chunk
+*/
+static void* scanDepth(void* arg) {
+    ScanChunk* chunk = (ScanChunk*)arg;
+    int depth = 0;
+    int minDepth = INT_MAX;
+    for(int i = chunk->start; i < chunk->end; i++) {
+        char ch = chunk->exp[i];
+        depth += (ch == '(' || ch == '{') - (ch == ')' || ch == '}');
+        if(i != chunk->lastIndex && depth < minDepth) {
+            minDepth = depth;
+        }
+    }
+    chunk->depthChange = depth;
+    chunk->minDepth = minDepth;
+    return NULL;
+}
+
+/*
+Pass 2 of the bracket depth prefix scan: finds the operators outside of every bracket, where the segment can be split
+*/
+static void* scanSplits(void* arg) {
+    ScanChunk* chunk = (ScanChunk*)arg;
+    char* exp = chunk->exp;
+    int depth = chunk->startDepth;
+    int failed = 0;
+    for(int i = chunk->start; i < chunk->end; i++) {
+        char ch = exp[i];
+        if(depth == 0) {
+            //A minus is binary if it follows a number or a closing bracket, the same rule evaluateExpression uses
+            if(ch == '+' || (ch == '-' && i > chunk->segmentStart && (isdigit(exp[i-1]) || exp[i-1] == ')' || exp[i-1] == '}'))) {
+                failed |= appendPosition(&chunk->additive, &chunk->numAdditive, &chunk->additiveCapacity, i);
+            } else if(ch == '*' || ch == '/') {
+                failed |= appendPosition(&chunk->multiplicative, &chunk->numMultiplicative, &chunk->multiplicativeCapacity, i);
+            }
+        }
+        depth += (ch == '(' || ch == '{') - (ch == ')' || ch == '}');
+    }
+    if(failed) {//Report a failed allocation as a chunk that couldn't be scanned
+        chunk->startDepth = -1;
+    }
+    return NULL;
+}
+
+/*
+Evaluates the characters from start to end on the calling thread, in place and without validating them again.
+The character at end (the operator or bracket after the range) is replaced with '\0' while the range is evaluated, then restored.
+This is safe while other threads evaluate the neighbouring ranges, because evaluation never looks before the first character of a range
+and no other thread reads the character at end until every thread has joined.
+Returns the result of evaluateValidatedExpression
+*/
+static double evaluateRange(char* exp, int start, int end) {
+    char after = exp[end];
+    exp[end] = '\0';
+    double result = evaluateValidatedExpression(exp + start);
+    exp[end] = after;
+    return result;
+}
+
+static int termStart(TermQueue* queue, int term) {
+    return term == 0 ? queue->segmentStart : queue->splits[term-1] + 1;
+}
+
+static int termEnd(TermQueue* queue, int term) {
+    return term == queue->numTerms - 1 ? queue->segmentEnd : queue->splits[term];
+}
+
+/*
+Takes groups of terms from the queue and evaluates them until no terms are left.
+Terms long enough to be worth splitting again are skipped here and evaluated in parallel afterwards.
+*/
+static void* evaluateTerms(void* arg) {
+    TermQueue* queue = *(TermQueue**)arg;
+
+    while(1) {
+        pthread_mutex_lock(&queue->lock);
+        int first = queue->nextTerm;
+        queue->nextTerm += TERMS_PER_TASK;
+        pthread_mutex_unlock(&queue->lock);
+        if(first >= queue->numTerms) {
+            break;
+        }
+
+        int last = first + TERMS_PER_TASK < queue->numTerms ? first + TERMS_PER_TASK : queue->numTerms;
+        for(int term = first; term < last; term++) {
+            int start = termStart(queue, term);
+            int end = termEnd(queue, term);
+            if(end - start < PARALLEL_THRESHOLD) {
+                queue->results[term] = evaluateRange(queue->exp, start, end);
+            }
+        }
+    }
+    return NULL;
+}
+
+/*
+Evaluates the characters from start to end, splitting them into independent terms that are evaluated in parallel.
+The terms are joined strictly left to right afterwards, so the result is the same as evaluateExpression.
+Returns NAN if an error has occurred
+*/
+static double evaluateSegment(char* exp, int start, int end, int numThreads) {
+    double result = NAN;
+
+    if(end - start < PARALLEL_THRESHOLD || numThreads < 2) {
+        return evaluateRange(exp, start, end);
+    }
+
+    //Split the segment into one chunk per thread
+    ScanChunk chunks[MAX_THREADS];
+    memset(chunks, 0, sizeof(chunks));
+    int chunkLength = (end - start + numThreads - 1) / numThreads;
+    for(int t = 0; t < numThreads; t++) {
+        chunks[t].exp = exp;
+        chunks[t].segmentStart = start;
+        chunks[t].lastIndex = end - 1;
+        chunks[t].start = start + t * chunkLength < end ? start + t * chunkLength : end;
+        chunks[t].end = chunks[t].start + chunkLength < end ? chunks[t].start + chunkLength : end;
+    }
+
+    //Pass 1 and the prefix scan: find the depth at the start of every chunk
+    runThreads(scanDepth, chunks, sizeof(ScanChunk), numThreads);
+    int depth = 0;
+    int minDepth = INT_MAX;
+    for(int t = 0; t < numThreads; t++) {
+        chunks[t].startDepth = depth;
+        if(chunks[t].minDepth != INT_MAX && depth + chunks[t].minDepth < minDepth) {
+            minDepth = depth + chunks[t].minDepth;
+        }
+        depth += chunks[t].depthChange;
+    }
+
+    //If one pair of brackets surrounds the whole segment, evaluate what is inside of them
+    if((exp[start] == '(' || exp[start] == '{') && minDepth >= 1) {
+        return evaluateSegment(exp, start + 1, end - 1, numThreads);
+    }
+
+    //Pass 2: find the operators outside of the brackets. Split at + and - if there are any, otherwise at * and /.
+    runThreads(scanSplits, chunks, sizeof(ScanChunk), numThreads);
+    int numSplits = 0;
+    bool additive = false;
+    bool failed = false;
+    for(int t = 0; t < numThreads; t++) {
+        additive |= chunks[t].numAdditive > 0;
+        failed |= chunks[t].startDepth == -1;
+    }
+    for(int t = 0; t < numThreads; t++) {
+        numSplits += additive ? chunks[t].numAdditive : chunks[t].numMultiplicative;
+    }
+
+    TermQueue queue;
+    queue.exp = exp;
+    queue.segmentStart = start;
+    queue.segmentEnd = end;
+    queue.numTerms = numSplits + 1;
+    queue.nextTerm = 0;
+    queue.splits = (int *)malloc((numSplits + 1) * sizeof(int));
+    queue.results = (double *)malloc((numSplits + 1) * sizeof(double));
+
+    if(failed || queue.splits == NULL || queue.results == NULL) {
+        printf("Memory allocation failed.\n");
+    } else if(numSplits == 0) {//There is nothing to split, such as a function applied to the whole segment
+        result = evaluateRange(exp, start, end);
+    } else {
+        numSplits = 0;
+        for(int t = 0; t < numThreads; t++) {
+            int count = additive ? chunks[t].numAdditive : chunks[t].numMultiplicative;
+            if(count > 0) {//A chunk without splits never allocated its list, and memcpy must not be given NULL
+                memcpy(queue.splits + numSplits, additive ? chunks[t].additive : chunks[t].multiplicative, count * sizeof(int));
+            }
+            numSplits += count;
+        }
+
+        //Fork: evaluate every term in parallel. Then join them in order from left to right.
+        TermQueue* queues[MAX_THREADS];
+        for(int t = 0; t < numThreads; t++) {
+            queues[t] = &queue;
+        }
+        pthread_mutex_init(&queue.lock, NULL);
+        runThreads(evaluateTerms, queues, sizeof(TermQueue*), numThreads);
+        pthread_mutex_destroy(&queue.lock);
+
+        for(int term = 0; term < queue.numTerms; term++) {
+            int termLength = termEnd(&queue, term) - termStart(&queue, term);
+            if(termLength >= PARALLEL_THRESHOLD) {
+                queue.results[term] = evaluateSegment(exp, termStart(&queue, term), termEnd(&queue, term), numThreads);
+            }
+        }
+
+        result = queue.results[0];
+        for(int term = 1; term < queue.numTerms && !isnan(result); term++) {
+            result = isnan(queue.results[term]) ? NAN : evaluateOp(exp[queue.splits[term-1]], result, queue.results[term]);
+            if(isnan(result)) {
+                printf("Error: Invalid operation.\n");
+            }
+        }
+    }
+
+    for(int t = 0; t < numThreads; t++) {
+        free(chunks[t].additive);
+        free(chunks[t].multiplicative);
+    }
+    free(queue.splits);
+    free(queue.results);
+    return result;
+}
+
+/*
+Evaluates a very long expression using several threads.
+The bracket depth of every character is found with a parallel prefix scan, the expression is split at its lowest precedence
+operators outside of any brackets, and the resulting terms are evaluated in parallel and then joined from left to right.
+Expressions shorter than PARALLEL_THRESHOLD are passed straight to evaluateExpression.
+The expression is validated once. Each term is then evaluated in place, so exp must be writable; it is the same as before when this returns.
+numThreads: The number of threads to use, or 0 to use one thread per processor
+Returns a double of the expression result
+Returns NAN if an error has occurred or input was invalid
+*/
+double evaluateExpressionParallel(char* exp, int numThreads) {
+    if(numThreads <= 0) {
+        numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if(numThreads > MAX_THREADS) {
+        numThreads = MAX_THREADS;
+    }
+
+    int length = strlen(exp);
+    if(length < PARALLEL_THRESHOLD || numThreads < 2) {
+        return evaluateExpression(&exp);
+    }
+
+    if(!validateExpression(exp)) {
+        printf("Error: Invalid input\n");
+        return NAN;
+    }
+    return evaluateSegment(exp, 0, length, numThreads);
+}
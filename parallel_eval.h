@@ -0,0 +1,10 @@
+#ifndef parallel_eval_h
+#define parallel_eval_h
+
+#define PARALLEL_THRESHOLD 65536 //Expressions (or parts of expressions) shorter than this many characters are evaluated on one thread
+#define MAX_THREADS 64 //The most threads used to evaluate a single expression
+#define TERMS_PER_TASK 256 //The number of terms a thread evaluates each time it takes work from the shared queue
+
+double evaluateExpressionParallel(char* exp, int numThreads);
+
+#endif
@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "stack.h"
+#include "calculator.h"
+#include "validator.h"
+#include "postfix.h"
+
+void initPostfix(Postfix* p) {
+    p->tokens = NULL;
+    p->length = 0;
+    p->capacity = 0;
+}
+
+void freePostfix(Postfix* p) {
+    free(p->tokens);
+    initPostfix(p);
+}
+
+/*
+Adds a token to the end of the postfix expression
+Returns 0 if the token was added, returns 1 if memory allocation failed
+*/
+int appendPostfix(Postfix* p, char op, double value) {
+    if(p->length == p->capacity) {//If the token array is full, expand it
+        int capacity = p->capacity == 0 ? INITIAL_CAPACITY : p->capacity * 2;
+        PostfixToken* tokens = (PostfixToken *)realloc(p->tokens, capacity * sizeof(PostfixToken));
+        if(tokens == NULL) {
+            printf("Memory allocation failed.\n");
+            return 1;
+        }
+        p->tokens = tokens;
+        p->capacity = capacity;
+    }
+    p->tokens[p->length].op = op;
+    p->tokens[p->length].value = value;
+    p->length++;
+    return 0;
+}
+
+/*
+Appends the postfix tokens of an infix expression to p. On an error, the tokens appended so far are left in p.
+Returns 0 if the expression was compiled, returns 1 if the expression was invalid
+*/
+static int compileTokens(char* exp, Postfix* p) {
+    if(!validateExpression(exp)) {
+        printf("Error: Invalid input\n");
+        return 1;
+    }
+
+    Operators operators;
+    initOperator(&operators);
+
+    int inputIndex = 0;
+    while(exp[inputIndex] != '\0') {
+        char token = exp[inputIndex];
+        if(isNumber(token)) {
+            double value = findNumber(exp, &inputIndex);
+            if(isnan(value) || appendPostfix(p, NUMBER_TOKEN, value)) {
+                return 1;
+            }
+        } else if(isOperator(token)) {
+            char op = '\0';//Stores the current operator
+            //If the previous token is an operator or the start of the expression or an opening brace, use unary minus
+            if(token == '-' && (inputIndex == 0 || isOperator(exp[inputIndex-1]) || exp[inputIndex-1] == '(' || exp[inputIndex-1] == '{')) {
+                //A unary minus cannot be the end of the expression, followed by a closing bracket, or followed by a binary operator
+                if(exp[inputIndex+1] == '\0' ||
+                    exp[inputIndex+1] == ')' ||
+                    exp[inputIndex+1] == '}' ||
+                    (isOperator(exp[inputIndex+1]) && !isUnary(exp[inputIndex+1]))) {
+                        printf("Error: Improper use of minus.\n");
+                        return 1;
+                    }
+                op = 'm';
+                inputIndex++;
+            } else {
+                op = findOperator(exp, &inputIndex);
+            }
+
+            if(op == '\0') {
+                printf("Error: Invalid Operation\n");
+                return 1;
+            }
+            while(operators.top >= 0 &&
+                    peekOperator(&operators) != '(' &&
+                    peekOperator(&operators) != '{' &&
+                    precedence(peekOperator(&operators)) >= precedence(op)
+            ) {
+                if(appendPostfix(p, popOperator(&operators), 0)) {
+                    return 1;
+                }
+            }
+            if(pushOperator(&operators, op)) {
+                return 1;
+            }
+        } else if(token == '(' || token == '{') {
+            if(pushOperator(&operators, token)) {
+                return 1;
+            }
+            inputIndex++;
+        } else {//A closing bracket. The validator has already checked that the brackets match.
+            while(operators.top >= 0 && peekOperator(&operators) != '(' && peekOperator(&operators) != '{') {
+                if(appendPostfix(p, popOperator(&operators), 0)) {
+                    return 1;
+                }
+            }
+            popOperator(&operators); //Pop the '(' or '{'
+            inputIndex++;
+        }
+    }
+
+    while(operators.top >= 0) {
+        if(appendPostfix(p, popOperator(&operators), 0)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+Compiles an infix expression into postfix order so that it can be stored or evaluated many times without parsing it again.
+This follows the same shunting-yard rules as evaluateExpression, but outputs operators instead of applying them.
+If the expression is invalid, p is left empty so that a partial expression can never be evaluated by mistake.
+Returns 0 if the expression was compiled, returns 1 if the expression was invalid
+*/
+int compileExpression(char* exp, Postfix* p) {
+    p->length = 0;
+    if(compileTokens(exp, p)) {
+        p->length = 0;
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Returns the number of operands that a postfix token takes from the stack: 0 for a number, 1 for a unary operator, and 2 for a binary operator
+*/
+int operandCount(char op) {
+    if(op == NUMBER_TOKEN) return 0;
+    if(isUnary(op) || op == 'm' || op == INTEGER_POWER_TOKEN) return 1;
+    return 2;
+}
+
+/*
+Evaluates a compiled postfix expression
+Any operation that returns NAN is treated as an error, even if a later operation (such as ^0) would hide it
+Returns a double of the expression result
+Returns NAN if an error has occurred or the expression is empty
+*/
+double evaluatePostfix(Postfix* p) {
+    Operands operands;
+    initOperand(&operands);
+
+    for(int i = 0; i < p->length; i++) {
+        char op = p->tokens[i].op;
+        double result;
+        if(op == NUMBER_TOKEN) {
+            result = p->tokens[i].value;
+        } else if(operandCount(op) == 1) {
+            double a = popOperand(&operands);
+            result = evaluateOp(op, a, p->tokens[i].value);
+        } else {
+            double b = popOperand(&operands);
+            double a = popOperand(&operands);
+            result = evaluateOp(op, a, b);
+        }
+
+        if(isnan(result)) {
+            printf("Error: Invalid operation.\n");
+            return NAN;
+        }
+        if(pushOperand(&operands, result)) {
+            return NAN;
+        }
+    }
+
+    //An empty expression, such as one that failed to compile, leaves no result on the stack
+    if(operands.top != 0) {
+        return NAN;
+    }
+    return popOperand(&operands);
+}
@@ -0,0 +1,27 @@
+#ifndef postfix_h
+#define postfix_h
+
+#define NUMBER_TOKEN '#' //The op of a postfix token that holds a number instead of an operator
+#define INTEGER_POWER_TOKEN 'q' //Raises its operand to the whole number stored in value. Only created by optimizePostfix.
+
+// A single token of a compiled expression. Operators use the same single-character symbols as evaluateOp.
+typedef struct{
+    char op;
+    double value; //Only used when op is NUMBER_TOKEN or INTEGER_POWER_TOKEN
+} PostfixToken;
+
+// An expression compiled into postfix (reverse Polish) order
+typedef struct{
+    PostfixToken* tokens;
+    int length;
+    int capacity;
+} Postfix;
+
+void initPostfix(Postfix* p);
+void freePostfix(Postfix* p);
+int appendPostfix(Postfix* p, char op, double value);
+int compileExpression(char* exp, Postfix* p);
+int operandCount(char op);
+double evaluatePostfix(Postfix* p);
+
+#endif
@@ -15,7 +15,8 @@ if [ "$last_two" != " 0" ]; then
     echo "Python script executed successfully, output: $python_output"
     
     # Now use the Python output to compile and run the C script
-    gcc -o calc_tester *.c
+    python3 validator_generator.py
+    gcc -o calc_tester *.c -lm -pthread
     if [ $? -eq 0 ]; then
         echo "C program compiled successfully."
         
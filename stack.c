@@ -11,7 +11,7 @@ void initOperand(Operands* s) {
 }
 
 int pushOperand(Operands* s, double value) {
-    if(s->top >= MAX) {
+    if(s->top >= MAX - 1) {
         printf("Overflow Error: Too many operands.\n");
         return 1;
     } 
@@ -60,7 +60,7 @@ void initOperator(Operators* s) {
 }
 
 int pushOperator(Operators* s, char value) {
-    if(s->top >= MAX) {
+    if(s->top >= MAX - 1) {
         printf("Overflow Error: Too many operands.\n");
         return 1;
     } 
@@ -4,6 +4,13 @@
 #include <math.h>
 #include <unistd.h>
 #include "calculator.h"
+#include "postfix.h"
+#include "optimizer.h"
+#include "float_batch.h"
+#include "autodiff.h"
+#include "parallel_eval.h"
+#include "deferred_eval.h"
+#include "expression_store.h"
 
 //#define MAX_EXPECTED_RESULT 100
 #define ACCURACY 3 //The number of rounding digits of accuracy that must be met for an expression result to be classified as "equal"
@@ -14,6 +21,13 @@
 #define INVALID_EXPRESSIONS_OUTPUT "Output/failed_invalid_expressions.csv"
 #define PASSED_VALID_EXPRESSIONS_OUTPUT "Output/passed_valid_expressions.csv"
 #define PASSED_INVALID_EXPRESSIONS_OUTPUT "Output/passed_invalid_expressions.csv"
+#define FLOAT_BATCH_TEMPLATE_SIZE 2048 //The number of expressions generated from each template of the float batch test
+#define FLOAT_BATCH_SEED 20240611 //The seed of the float batch test, so that every run tests the same expressions
+#define PARALLEL_TEST_LENGTH (PARALLEL_THRESHOLD + PARALLEL_THRESHOLD / 4) //The length of the expressions in the parallel test, long enough to be split
+#define PARALLEL_TEST_THREADS 4 //The number of threads used by the parallel test, even on a computer with fewer processors
+#define STORE_TEST_SIZE 4096 //The number of generated expressions in the expression store test, half added before sealStore and half after
+#define GRADIENT_STEP 1e-6 //The step of the central finite differences in the gradient test, relative to the input
+#define GRADIENT_TOLERANCE 1e-7 //The largest difference allowed between a partial derivative and its finite difference, relative to the derivative
 
 /**
 Rounds a double value to a certain number of precision. If the value is NaN, then NaN is returned instead.
@@ -56,6 +70,32 @@ bool compareExpression(char* expression, double expectedResult, double *calculat
     return expectedResult == roundedCalculatorResult || (isnan(expectedResult) && isnan(roundedCalculatorResult));
 }
 
+/**
+Evaluates an expression through compileExpression, optimizePostfix and evaluatePostfix and compares it to the expected result,
+the same way compareExpression does. optimizePostfix must never change whether an expression passes.
+
+@param expression The mathematical expression to be tested
+@param expectedResult The value of the result that should be obtained from the test expression.
+@return true if the optimized result matches, and returns false otherwise.
+*/
+bool compareOptimized(char* expression, double expectedResult) {
+    expectedResult = roundValue(expectedResult, ACCURACY);
+    Postfix postfix;
+    initPostfix(&postfix);
+    double optimizedResult = nan("");
+
+    freopen("/dev/null", "w", stdout);
+    if(compileExpression(expression, &postfix) == 0) {
+        optimizePostfix(&postfix);
+        optimizedResult = evaluatePostfix(&postfix);
+    }
+    freopen("/dev/tty", "w", stdout);
+
+    freePostfix(&postfix);
+    double roundedOptimizedResult = roundValue(optimizedResult, ACCURACY);
+    return expectedResult == roundedOptimizedResult || (isnan(expectedResult) && isnan(roundedOptimizedResult));
+}
+
 /**
 Reads a single csv file and compares every expression to the expression in the CSV file.
 Once all expression are tested, the successful expression statistics are printed to the screen.
@@ -63,10 +103,11 @@ Once all expression are tested, the successful expression statistics are printed
 @param outputFileName The path of the CSV file to be output that contains non-matching expressions.
 @param title The title to be output to the screen describing what the statistics represent
 @param maxLength The longest expected line to be read from the CSV file. 
+@param numOptimizerChanged Incremented for every expression that passes or fails differently after optimizePostfix
 
 @return 0 if expression evaluation was successful. Returns 1 if any errors occured. 
 */
-int testExpressions(char* fileName, char* outputFileName, char* passedOutputFileName, char* title, int maxLength) {
+int testExpressions(char* fileName, char* outputFileName, char* passedOutputFileName, char* title, int maxLength, int* numOptimizerChanged) {
     FILE *file;
     char line[maxLength];
     char expression[maxLength+1];
@@ -75,6 +116,7 @@ int testExpressions(char* fileName, char* outputFileName, char* passedOutputFile
     bool isMatching;//Stores the comparison result of each expression test. True if the expression matches, false otherwise.
     int numMatching = 0;//The number of expressions that match the expected result
     int numNotMatching = 0;//The number of expressions that do not match the expected result
+    int numChanged = 0;//The number of expressions in this file that pass or fail differently after optimizePostfix
 
     // Open the expressions file in read-only mode
     file = fopen(fileName, "r");
@@ -148,7 +190,7 @@ int testExpressions(char* fileName, char* outputFileName, char* passedOutputFile
         bool isMatching = false;
 
         if(expected_result[0] == 'n' && expected_result[1] == 'a' && expected_result[2] == 'n') { // Compare invalid expressions
-            if isnan(calculator_result) { // If it was expected to be nan and it is nan
+            if(isnan(calculator_result)) { // If it was expected to be nan and it is nan
                 isMatching = true; // Then that's a valid outcome
                 // For matching invalid expressions, these must be written to the file with the string "nan" because file writing when double in not a number leads to unexpected output.
                 fprintf(passedOutputFile, "%s, %s, %s", expression, "nan", expected_result); //Append the bad expression to the end of the output file so that it can reviewed later
@@ -159,7 +201,13 @@ int testExpressions(char* fileName, char* outputFileName, char* passedOutputFile
                 printf("Failed invalid expression\n");
             }
         } else { // Compare valid expressions
-            isMatching = compareExpression(expression, strtod(expected_result, &resultEndPtr), &calculator_result);
+            double expected = strtod(expected_result, &resultEndPtr);
+            bool optimizedMatching = compareOptimized(expression, expected);
+            isMatching = compareExpression(expression, expected, &calculator_result);
+            if(optimizedMatching != isMatching) {
+                printf("optimizePostfix changed the result of: %s\n", expression);
+                numChanged++;
+            }
         }
         
         if(isMatching) {
@@ -176,9 +224,458 @@ int testExpressions(char* fileName, char* outputFileName, char* passedOutputFile
     printf("Passed tests: %.2f%% \n", (double)numMatching/(numMatching+numNotMatching) * 100);
     printf("# Correct Evaluations: %i\n", numMatching);
     printf("# Incorrect Evaluations: %i\n", numNotMatching);
+    printf("# Evaluations changed by optimizePostfix: %i\n", numChanged);
+    *numOptimizerChanged += numChanged;
     return 0;
 }
 
+/**
+Tests that evaluateFloatBatch rounds every result to the same value as evaluatePostfix at ACCURACY decimal places.
+The expressions are built to be hard for single precision: many land exactly on or next to a rounding halfway point,
+and some are too large or too small for single precision to ever meet ACCURACY, so the fallback to double precision is tested too.
+
+@return 0 if every result matches. Returns 1 if any result doesn't match or an error occurs.
+*/
+int testFloatBatch() {
+    const char* templates[] = {
+        "%d.%03d5+%d.%03d0", //Exactly halfway in decimal, but not in binary
+        "%d.%03d5-%d.%03d0-0.0000001", //Just below halfway
+        "%d/16-%d.%03d0/16", //Halfway points that are exact in binary
+        "%d.%03d5/%d*%d", //Halfway after a division is undone
+        "(%d.%03d5-%d.%03d)^2", //Integer powers
+        "-%d.%03d5^-3+%d.%03d^3", //Negative integer powers and unary minus
+        "98530198262008*%d.%03d5-%d.%03d", //Too large for single precision to meet ACCURACY
+        "0.0000001*%d.%03d5/%d.%03d" //Too small to have any digits at ACCURACY, or a division by 0
+    };
+    int numTemplates = sizeof(templates) / sizeof(templates[0]);
+    int count = numTemplates * FLOAT_BATCH_TEMPLATE_SIZE;
+    Postfix* expressions = (Postfix *)malloc(count * sizeof(Postfix));
+    double* results = (double *)malloc(count * sizeof(double));
+    if(expressions == NULL || results == NULL) {
+        printf("Error: memory allocation failed.\n");
+        free(expressions);
+        free(results);
+        return 1;
+    }
+
+    srand(FLOAT_BATCH_SEED);
+    char expression[100];
+    for(int i = 0; i < count; i++) {
+        snprintf(expression, sizeof(expression), templates[i / FLOAT_BATCH_TEMPLATE_SIZE],
+            rand() % 1000, rand() % 1000, rand() % 1000, rand() % 1000);
+        initPostfix(&expressions[i]);
+        compileExpression(expression, &expressions[i]); //An expression that fails to compile is left empty and evaluates to NaN
+        optimizePostfix(&expressions[i]);
+    }
+
+    FloatBatch batch;
+    int numMismatched = 0;
+    freopen("/dev/null", "w", stdout);
+    int failed = initFloatBatch(&batch, expressions, count);
+    int numDouble = failed ? 0 : evaluateFloatBatch(&batch, ACCURACY, results);
+    for(int i = 0; i < count && !failed; i++) {
+        double expected = roundValue(evaluatePostfix(&expressions[i]), ACCURACY);
+        double actual = roundValue(results[i], ACCURACY);
+        if(!(expected == actual || (isnan(expected) && isnan(actual)))) {
+            numMismatched++;
+        }
+    }
+    freopen("/dev/tty", "w", stdout);
+
+    printf("*********Float Batch*********\n");
+    if(failed) {
+        printf("Error: memory allocation failed.\n");
+    } else {
+        printf("# Evaluations: %i\n", count);
+        printf("# Evaluated again in double precision: %i\n", numDouble);
+        printf("# Results that round differently than evaluatePostfix: %i\n", numMismatched);
+        freeFloatBatch(&batch);
+    }
+
+    for(int i = 0; i < count; i++) {
+        freePostfix(&expressions[i]);
+    }
+    free(expressions);
+    free(results);
+    return failed || numMismatched != 0;
+}
+
+/**
+Returns the central finite difference (f(x+h) - f(x-h)) / 2h of a compiled expression with respect to the number stored in token index,
+where h is GRADIENT_STEP relative to the number. The number is restored afterwards.
+*/
+double finiteDifference(Postfix* p, int index) {
+    double x = p->tokens[index].value;
+    double h = GRADIENT_STEP * fmax(1, fabs(x));
+    p->tokens[index].value = x + h;
+    double above = evaluatePostfix(p);
+    p->tokens[index].value = x - h;
+    double below = evaluatePostfix(p);
+    p->tokens[index].value = x;
+    return (above - below) / (2 * h);
+}
+
+/**
+Tests that evaluateGradient matches central finite differences for every input of expressions that use every operator.
+Integer powers only exist after optimizePostfix, so those expressions are optimized first and must contain an INTEGER_POWER_TOKEN.
+
+@return 0 if every partial derivative matches. Returns 1 if any partial derivative doesn't match or an error occurs.
+*/
+int testGradient() {
+    const char* expressions[] = {
+        "1.5+2.25*3.5-4.75/1.25",
+        "2.5^1.7+1.3^(0.5*2.1)",
+        "sin(0.7)*cos(1.3)+tan(0.4)",
+        "cot(0.9)-cot(-2.1)*2",
+        "ln(3.7)+log(12.5)*2",
+        "-(1.2*-3.4)+-(-0.6)",
+        "{2.5^7+1.3^5-0.7^9}/100",
+        "(1.5-0.25)^-3*4.5^2",
+        "sin(1.1^3)/cot(0.3)^2"
+    };
+    int numOptimized = 3; //The last expressions are optimized so that they test integer powers
+    int numExpressions = sizeof(expressions) / sizeof(expressions[0]);
+    int numPartials = 0;
+    int numMismatched = 0;
+    int failed = 0;
+    char expression[100];
+
+    freopen("/dev/null", "w", stdout);
+    for(int e = 0; e < numExpressions && !failed; e++) {
+        Postfix postfix;
+        initPostfix(&postfix);
+        strcpy(expression, expressions[e]);
+        if(compileExpression(expression, &postfix)) {
+            failed = 1;
+            break;
+        }
+        if(e >= numExpressions - numOptimized) {
+            optimizePostfix(&postfix);
+            bool hasIntegerPower = false;
+            for(int i = 0; i < postfix.length; i++) {
+                hasIntegerPower |= postfix.tokens[i].op == INTEGER_POWER_TOKEN;
+            }
+            numMismatched += !hasIntegerPower;
+        }
+
+        int n = countInputs(&postfix);
+        double* gradient = (double *)malloc(n * sizeof(double));
+        if(gradient == NULL || isnan(evaluateGradient(&postfix, gradient))) {
+            failed = 1;
+        }
+        for(int i = 0, input = 0; i < postfix.length && !failed; i++) {
+            if(postfix.tokens[i].op != NUMBER_TOKEN) {
+                continue;
+            }
+            double expected = finiteDifference(&postfix, i);
+            double actual = gradient[input++];
+            numPartials++;
+            if(!(fabs(actual - expected) <= GRADIENT_TOLERANCE * fmax(1, fabs(actual)))) {
+                numMismatched++;
+            }
+        }
+        free(gradient);
+        freePostfix(&postfix);
+    }
+    freopen("/dev/tty", "w", stdout);
+
+    printf("*********Gradient*********\n");
+    if(failed) {
+        printf("Error: a gradient test expression could not be evaluated.\n");
+    } else {
+        printf("# Partial derivatives: %i\n", numPartials);
+        printf("# Partial derivatives that differ from central finite differences: %i\n", numMismatched);
+    }
+    return failed || numMismatched != 0;
+}
+
+/**
+Returns true if an expression in the store evaluates to exactly the same value as evaluateExpression, or both are NaN
+*/
+bool compareHandle(ExpressionStore* store, int handle, const char* expression) {
+    char copy[100];
+    strcpy(copy, expression);
+    char* input = copy;
+    double expected = evaluateExpression(&input);
+    double actual = evaluateHandle(store, handle);
+    return actual == expected || (isnan(actual) && isnan(expected));
+}
+
+/**
+Tests that evaluateHandle gives exactly the same result as evaluateExpression for every expression in an ExpressionStore,
+both before and after sealStore, and that expressions can still be added and evaluated after the store has been sealed.
+The expressions share subexpressions, include numbers on both sides of the inline number limits, and include invalid expressions.
+Handles that don't start a node must evaluate to NaN.
+
+@return 0 if every result is the same. Returns 1 if any result differs or an error occurs.
+*/
+int testStore() {
+    const char* templates[] = {
+        "%d.%03d*(%d+%d.5)-%d/7", //Inline numbers
+        "%d.%03d1^2+sin(%d.25)/%d-%d", //Numbers with too many decimals to be inline
+        "67108863*%d.%d-67108864/%d+%d-%d", //The largest inline mantissa and the smallest one that isn't
+        "(%d+%d)*(%d+%d)/%d", //Shared subexpressions
+        "%d/(%d-%d)+%d*0-%d", //Division by zero for some numbers
+        "%d.%03d+*%d-%d-%d" //Invalid
+    };
+    const char* fixed[] = {"7", "13.75", "0.001", "0.0001", "-67108863.999", "123456.789", "1e5"};
+    int numTemplates = sizeof(templates) / sizeof(templates[0]);
+    int numFixed = sizeof(fixed) / sizeof(fixed[0]);
+    char (*expressions)[100] = malloc(STORE_TEST_SIZE * sizeof(*expressions));
+    int* handles = (int *)malloc(STORE_TEST_SIZE * sizeof(int));
+    if(expressions == NULL || handles == NULL) {
+        printf("Error: memory allocation failed.\n");
+        free(expressions);
+        free(handles);
+        return 1;
+    }
+
+    srand(FLOAT_BATCH_SEED);
+    for(int i = 0; i < STORE_TEST_SIZE; i++) {
+        if(i % (STORE_TEST_SIZE / 2) < numFixed) {
+            strcpy(expressions[i], fixed[i % (STORE_TEST_SIZE / 2)]);
+        } else {
+            snprintf(expressions[i], sizeof(expressions[i]), templates[rand() % numTemplates],
+                rand() % 20, rand() % 1000, rand() % 20, rand() % 20, rand() % 20);
+        }
+    }
+
+    ExpressionStore store;
+    initStore(&store);
+    int numDifferent = 0;
+    int numStored = 0;
+    freopen("/dev/null", "w", stdout);
+    for(int i = 0; i < STORE_TEST_SIZE; i++) {
+        if(i == STORE_TEST_SIZE / 2) {//Seal the store halfway, then check that it still gives the same results and can still grow
+            sealStore(&store);
+            for(int j = 0; j < i; j++) {
+                numDifferent += !compareHandle(&store, handles[j], expressions[j]);
+            }
+        }
+        char copy[100];
+        strcpy(copy, expressions[i]);
+        handles[i] = storeExpression(&store, copy);
+        numStored += handles[i] != INVALID_HANDLE;
+        if(i >= STORE_TEST_SIZE / 2 && i - STORE_TEST_SIZE / 2 < numFixed) {//The same expression added again after sealStore is not stored twice
+            numDifferent += handles[i] != handles[i - STORE_TEST_SIZE / 2];
+        }
+        numDifferent += !compareHandle(&store, handles[i], expressions[i]);
+    }
+    sealStore(&store);
+    for(int i = 0; i < STORE_TEST_SIZE; i++) {
+        numDifferent += !compareHandle(&store, handles[i], expressions[i]);
+        //The byte after a handle is part of its node, so it is never a valid handle
+        numDifferent += handles[i] != INVALID_HANDLE && !isnan(evaluateHandle(&store, handles[i] + 1));
+    }
+    numDifferent += !isnan(evaluateHandle(&store, store.codeLength));
+    freopen("/dev/tty", "w", stdout);
+
+    printf("*********Expression Store*********\n");
+    printf("# Expressions: %i\n", STORE_TEST_SIZE);
+    printf("# Expressions stored: %i\n", numStored);
+    printf("# Nodes: %i\n", store.nodeCount);
+    printf("# Results that differ from evaluateExpression: %i\n", numDifferent);
+    freeStore(&store);
+    free(expressions);
+    free(handles);
+    return numDifferent != 0;
+}
+
+/**
+Tests that evaluatePostfixDeferred and evaluateBatchDeferred give exactly the same results as evaluatePostfix.
+Many of the expressions raise a floating-point exception, so the deferred check has to find them and evaluate them again,
+and some are left empty because they fail to compile. Every expression is tested as compiled and after optimizePostfix.
+
+@return 0 if every result is the same. Returns 1 if any result differs or an error occurs.
+*/
+int testDeferred() {
+    const char* expressions[] = {
+        "1.5+2.25*3.5-4.75/1.25",
+        "sin(0.7)*cos(1.3)+tan(0.4)-cot(0.9)",
+        "ln(3.7)+log(12.5)^2.5",
+        "2.5^7+1.3^5-0.7^-9",
+        "-(-3.5)*-2",
+        "1/0", //Division by zero
+        "1/(2-2)+3",
+        "ln(0)", //Division by zero exception
+        "log(-1)", //Invalid operation
+        "(-8)^(1/3)",
+        "0^-1",
+        "cot(0)",
+        "10^308*10", //Overflow
+        "-9^323+-9^323",
+        "cot(0.0000001/10^308)",
+        "2^1024-2^1024",
+        "1/(1/0)", //An exception that still leads to a finite result
+        "1/(10^308*10)+1",
+        "2^(1/ln(0))",
+        "1+*2", //Fails to compile
+        ""
+    };
+    int numExpressions = sizeof(expressions) / sizeof(expressions[0]);
+    int count = 2 * numExpressions;
+    Postfix postfixes[count];
+    double results[count];
+    char expression[100];
+
+    freopen("/dev/null", "w", stdout);
+    for(int i = 0; i < count; i++) {
+        strcpy(expression, expressions[i % numExpressions]);
+        initPostfix(&postfixes[i]);
+        compileExpression(expression, &postfixes[i]); //An expression that fails to compile is left empty and evaluates to NaN
+        if(i >= numExpressions) {
+            optimizePostfix(&postfixes[i]);
+        }
+    }
+    evaluateBatchDeferred(postfixes, count, results);
+    int numDifferent = 0;
+    for(int i = 0; i < count; i++) {
+        double expected = evaluatePostfix(&postfixes[i]);
+        double deferred = evaluatePostfixDeferred(&postfixes[i]);
+        numDifferent += !(deferred == expected || (isnan(deferred) && isnan(expected)));
+        numDifferent += !(results[i] == expected || (isnan(results[i]) && isnan(expected)));
+        freePostfix(&postfixes[i]);
+    }
+    freopen("/dev/tty", "w", stdout);
+
+    printf("*********Deferred Exceptions*********\n");
+    printf("# Evaluations: %i\n", count);
+    printf("# Results that differ from evaluatePostfix: %i\n", numDifferent);
+    return numDifferent != 0;
+}
+
+/**
+Tests that evaluateExpressionParallel gives exactly the same result as evaluateExpression and leaves the expression unchanged.
+Each expression is longer than PARALLEL_THRESHOLD and has brackets and unary minus outside of every bracket, where it is split into terms.
+It is tested as it is, surrounded by one pair of brackets, and as a bracketed term that is long enough to be split again.
+
+@return 0 if every result is the same and every expression is unchanged. Returns 1 otherwise.
+*/
+int testParallel() {
+    const char* terms[] = {
+        "%d.%02d*(%d.%02d-%d.%02d)",
+        "-%d.%02d/{%d.%02d+1}-%d",
+        "(-%d.%02d)^2*%d.%02d/%d",
+        "-(%d.%02d+%d.%02d)*-%d"
+    };
+    int numTerms = sizeof(terms) / sizeof(terms[0]);
+    int capacity = PARALLEL_TEST_LENGTH + 100;
+    char* expression = (char *)malloc(capacity);
+    char* wrapped = (char *)malloc(capacity + 100);
+    char* copy = (char *)malloc(capacity + 100);
+    if(expression == NULL || wrapped == NULL || copy == NULL) {
+        printf("Error: memory allocation failed.\n");
+        free(expression);
+        free(wrapped);
+        free(copy);
+        return 1;
+    }
+
+    srand(FLOAT_BATCH_SEED);
+    int length = 0;
+    while(length < PARALLEL_TEST_LENGTH) {
+        if(length > 0) {
+            expression[length++] = rand() % 2 ? '+' : '-';
+        }
+        length += snprintf(expression + length, capacity - length, terms[rand() % numTerms],
+            rand() % 100, rand() % 100, rand() % 100, rand() % 100, rand() % 100 + 1, rand() % 100);
+    }
+
+    const char* formats[] = {"%s", "(%s)", "2*{%s}-1"};
+    int numFormats = sizeof(formats) / sizeof(formats[0]);
+    int numDifferent = 0;
+    int numChanged = 0;
+    int numNaN = 0;
+    freopen("/dev/null", "w", stdout);
+    for(int i = 0; i < numFormats; i++) {
+        snprintf(wrapped, capacity + 100, formats[i], expression);
+        strcpy(copy, wrapped);
+        char* input = copy;
+        double serial = evaluateExpression(&input);
+        double parallel = evaluateExpressionParallel(wrapped, PARALLEL_TEST_THREADS);
+        numNaN += isnan(serial);
+        numDifferent += memcmp(&serial, &parallel, sizeof(double)) != 0;
+        snprintf(copy, capacity + 100, formats[i], expression);
+        numChanged += strcmp(copy, wrapped) != 0;
+    }
+    freopen("/dev/tty", "w", stdout);
+
+    printf("*********Parallel*********\n");
+    printf("# Evaluations: %i\n", numFormats);
+    printf("# Expression length: %i\n", length);
+    printf("# Results that are NaN: %i\n", numNaN);
+    printf("# Results that differ from evaluateExpression: %i\n", numDifferent);
+    printf("# Expressions changed by evaluateExpressionParallel: %i\n", numChanged);
+    free(expression);
+    free(wrapped);
+    free(copy);
+    return numNaN != 0 || numDifferent != 0 || numChanged != 0;
+}
+
+/**
+Tests that evaluateExpressionBudget reports every status: each limit of the budget being exceeded, a cancelled evaluation,
+an invalid expression and a valid one. Every status except EVAL_OK must come with a NaN result,
+and an EVAL_OK result must be the same as evaluateExpression.
+
+@return 0 if every status and result is correct. Returns 1 otherwise.
+*/
+int testBudget() {
+    typedef struct{
+        const char* expression;
+        int maxTokens;
+        int maxDepth;
+        int maxExponentChain;
+        long maxSteps;
+        bool cancel; //Cancel the budget before evaluating
+        int expectedStatus;
+    } BudgetCase;
+    //A limit of 0 is not checked
+    const BudgetCase cases[] = {
+        {"1+2*3", DEFAULT_MAX_TOKENS, DEFAULT_MAX_DEPTH, DEFAULT_MAX_EXPONENT_CHAIN, DEFAULT_MAX_STEPS, false, EVAL_OK},
+        {"2^(1^(1^1))-{4/(2+3)}", 21, 2, 3, 0, false, EVAL_OK}, //Exactly at every limit of its cost
+        {"1+2+3+4", 0, 0, 0, 10, false, EVAL_OK}, //7 tokens and 3 operations
+        {"1+2+3+4", 6, 0, 0, 0, false, EVAL_BUDGET_EXCEEDED}, //7 tokens
+        {"((((1))))+1", 0, 3, 0, 0, false, EVAL_BUDGET_EXCEEDED}, //Depth 4
+        {"2^(1^(1^1))", 0, 0, 2, 0, false, EVAL_BUDGET_EXCEEDED}, //Exponent chain of 3
+        {"1+2+3+4", 0, 0, 0, 9, false, EVAL_BUDGET_EXCEEDED}, //10 steps
+        {"1+2", DEFAULT_MAX_TOKENS, DEFAULT_MAX_DEPTH, DEFAULT_MAX_EXPONENT_CHAIN, DEFAULT_MAX_STEPS, true, EVAL_CANCELLED},
+        {"1/0", DEFAULT_MAX_TOKENS, DEFAULT_MAX_DEPTH, DEFAULT_MAX_EXPONENT_CHAIN, DEFAULT_MAX_STEPS, false, EVAL_ERROR},
+        {"1+*2", DEFAULT_MAX_TOKENS, DEFAULT_MAX_DEPTH, DEFAULT_MAX_EXPONENT_CHAIN, DEFAULT_MAX_STEPS, false, EVAL_ERROR}
+    };
+    int numCases = sizeof(cases) / sizeof(cases[0]);
+    int numWrong = 0;
+    char expression[100];
+
+    freopen("/dev/null", "w", stdout);
+    for(int i = 0; i < numCases; i++) {
+        EvalBudget budget;
+        initBudget(&budget);
+        budget.maxTokens = cases[i].maxTokens;
+        budget.maxDepth = cases[i].maxDepth;
+        budget.maxExponentChain = cases[i].maxExponentChain;
+        budget.maxSteps = cases[i].maxSteps;
+        if(cases[i].cancel) {
+            cancelEvaluation(&budget);
+        }
+
+        int status;
+        strcpy(expression, cases[i].expression);
+        char* input = expression;
+        double result = evaluateExpressionBudget(&input, &budget, &status);
+        input = expression;
+        double expected = cases[i].expectedStatus == EVAL_OK ? evaluateExpression(&input) : NAN;
+        if(status != cases[i].expectedStatus || !(result == expected || (isnan(result) && isnan(expected)))) {
+            numWrong++;
+        }
+    }
+    freopen("/dev/tty", "w", stdout);
+
+    printf("*********Budget*********\n");
+    printf("# Evaluations: %i\n", numCases);
+    printf("# Wrong statuses or results: %i\n", numWrong);
+    return numWrong != 0;
+}
+
 /**
 The entry point of the calculator testing program. This program tests valid and invalid expressions by comparing previously-generated
 CSV files of expressions and expected results to the numerical output of calculator.c
@@ -222,8 +719,10 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    int numOptimizerChanged = 0;//Reported after every test has run, so a change from optimizePostfix doesn't hide the other results
+
     // Test the valid expressions
-    if(testExpressions(VALID_EXPRESSIONS, VALID_EXPRESSIONS_OUTPUT, PASSED_VALID_EXPRESSIONS_OUTPUT, "*********Valid Expressions*********", maxLength)) {
+    if(testExpressions(VALID_EXPRESSIONS, VALID_EXPRESSIONS_OUTPUT, PASSED_VALID_EXPRESSIONS_OUTPUT, "*********Valid Expressions*********", maxLength, &numOptimizerChanged)) {
         printf("Error testing valid expressions.\n");
         return 1;
     }
@@ -231,8 +730,56 @@ int main(int argc, char *argv[]) {
     printf("\n");
 
     // Test the invalid expressions
-    if(testExpressions(INVALID_EXPRESSIONS, INVALID_EXPRESSIONS_OUTPUT, PASSED_INVALID_EXPRESSIONS_OUTPUT, "*********Invalid Expressions*********", maxLength)) {
+    if(testExpressions(INVALID_EXPRESSIONS, INVALID_EXPRESSIONS_OUTPUT, PASSED_INVALID_EXPRESSIONS_OUTPUT, "*********Invalid Expressions*********", maxLength, &numOptimizerChanged)) {
         printf("Error testing invalid expressions.\n");
         return 1;
     }
+
+    printf("\n");
+
+    if(testFloatBatch()) {
+        printf("Error testing the float batch.\n");
+        return 1;
+    }
+
+    printf("\n");
+
+    if(testGradient()) {
+        printf("Error testing the gradient.\n");
+        return 1;
+    }
+
+    printf("\n");
+
+    if(testBudget()) {
+        printf("Error testing the evaluation budget.\n");
+        return 1;
+    }
+
+    printf("\n");
+
+    if(testParallel()) {
+        printf("Error testing parallel evaluation.\n");
+        return 1;
+    }
+
+    printf("\n");
+
+    if(testDeferred()) {
+        printf("Error testing deferred exceptions.\n");
+        return 1;
+    }
+
+    printf("\n");
+
+    if(testStore()) {
+        printf("Error testing the expression store.\n");
+        return 1;
+    }
+
+    if(numOptimizerChanged != 0) {
+        printf("Error: optimizePostfix changed the result of %i expressions.\n", numOptimizerChanged);
+        return 1;
+    }
+    return 0;
 }
\ No newline at end of file
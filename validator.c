@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "validator.h"
+#include "validator_table.h"
+
+/*
+Checks if the text at exp begins with one of the function names (sin, cos, tan, cot, ln, log)
+symbol: Set to the single-character operator used by findOperator for that function ('o' for cot, 'n' for ln, 'l' for log)
+Returns the number of characters in the function name, or 0 if exp does not begin with a function name
+*/
+int matchFunction(char* exp, char* symbol) {
+    switch(exp[0]) {
+        case 's':
+            if(exp[1] == 'i' && exp[2] == 'n') { *symbol = 's'; return 3; }
+            break;
+        case 'c':
+            if(exp[1] == 'o' && exp[2] == 's') { *symbol = 'c'; return 3; }
+            if(exp[1] == 'o' && exp[2] == 't') { *symbol = 'o'; return 3; }
+            break;
+        case 't':
+            if(exp[1] == 'a' && exp[2] == 'n') { *symbol = 't'; return 3; }
+            break;
+        case 'l':
+            if(exp[1] == 'n') { *symbol = 'n'; return 2; }
+            if(exp[1] == 'o' && exp[2] == 'g') { *symbol = 'l'; return 3; }
+            break;
+    }
+    return 0;
+}
+
+/*
+Checks the syntax of an expression in a single pass before it is evaluated.
+Every character is checked against the transition table that validator_generator.py builds from char_matrix.csv,
+and a bracket depth counter makes sure every () and {} pair is closed by the matching type.
+The validator accepts every expression that follows the grammar of char_matrix.csv, plus the extra sequences listed in validator_generator.py.
+It is stricter than the evaluator on its own: a number or bracket directly next to another bracket or number (such as 7(2), {4/2}6.8+93 or 5(3)49)
+is rejected here, while the evaluator used to ignore the missing operator and return one of the operands.
+Returns true if the expression could be valid, returns false if it is certainly invalid
+*/
+bool validateExpression(char* exp) {
+    unsigned int state = VALIDATOR_START; //The class of the previous token
+    int depth = 0; //The number of brackets that are currently open
+    unsigned long long braces = 0; //Bit x is set if the open bracket at depth x is a curly bracket
+    int i = 0;
+
+    while(exp[i] != '\0') {
+        unsigned int charClass = VALIDATOR_CLASS[(unsigned char)exp[i]];
+        int length = 1;
+
+        //Function names are multiple characters long, so they are matched separately and then use the class of their symbol
+        if(exp[i] >= 'a' && exp[i] <= 'z') {
+            char symbol = '\0';
+            length = matchFunction(&exp[i], &symbol);
+            if(length == 0) {
+                return false;
+            }
+            charClass = VALIDATOR_CLASS[(unsigned char)symbol];
+        }
+
+        if(charClass == VALIDATOR_INVALID || !((VALIDATOR_TRANSITIONS[state] >> charClass) & 1)) {
+            return false;
+        }
+
+        char token = VALIDATOR_TOKENS[charClass];
+        if(token == '(' || token == '{') {
+            if(depth == MAX_BRACKET_DEPTH) {
+                return false;
+            }
+            braces = (braces & ~(1ULL << depth)) | ((unsigned long long)(token == '{') << depth);
+            depth++;
+        } else if(token == ')' || token == '}') {
+            //A closing bracket must close an open bracket of the same type
+            if(depth == 0 || ((braces >> (depth-1)) & 1) != (unsigned long long)(token == '}')) {
+                return false;
+            }
+            depth--;
+        }
+
+        state = charClass;
+        i += length;
+    }
+
+    //The expression can't be empty, must end with a valid ending character, and must close every bracket
+    return state != VALIDATOR_START && ((VALIDATOR_END >> state) & 1) && depth == 0;
+}
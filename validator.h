@@ -0,0 +1,11 @@
+#ifndef validator_h
+#define validator_h
+
+#include <stdbool.h>
+
+#define MAX_BRACKET_DEPTH 64 //The deepest bracket nesting the validator accepts. Deeper nesting would overflow the MAX operator stack anyway.
+
+bool validateExpression(char* exp);
+int matchFunction(char* exp, char* symbol);
+
+#endif
@@ -0,0 +1,97 @@
+import csv
+import sys
+
+############### Generates validator_table.h from char_matrix.csv ###############
+# The rules in char_matrix.csv (which character may start an expression, end an expression, or follow another character)
+# are compiled into bitmask rows so that validator.c can check every character with a single table lookup.
+# Run "python3 validator_generator.py" whenever char_matrix.csv changes. runScripts.sh does this automatically before compiling.
+
+CHAR_FILENAME = "char_matrix.csv"
+TABLE_FILENAME = "validator_table.h"
+
+# The evaluator accepts a few sequences that the generator's matrix does not produce.
+# The validator must not reject well-formed input that evaluateExpression handles, so these transitions are added to the table.
+#   ".5", "(.5)", "{.5}" and "-.5": findNumber accepts a number that starts with a period
+#   "2--3": a binary minus may be followed by a unary minus
+EVALUATOR_EXTRAS = [
+    ("start", "."),
+    ("(", "."),
+    ("{", "."),
+    ("-", "."),
+    ("-", "-"),
+]
+
+# Reads the character matrix into a list of rows
+# @param fileName The path of the csv file to be read
+# @return An array containing the contents of the entire csv
+def readMatrix(fileName):
+    with open(fileName, mode='r', newline='', encoding='utf-8-sig') as file:
+        return [row for row in csv.reader(file)]
+
+# Converts a row of '0'/'1' strings into a bitmask where bit x is set if column x is allowed
+# @param row The list of '0'/'1' strings for one row of the matrix (without the row label)
+# @return The integer bitmask of the row
+def toMask(row):
+    mask = 0
+    for index, value in enumerate(row):
+        if value == '1':
+            mask |= 1 << index
+    return mask
+
+# Converts a token from the matrix into a C character literal
+# @param token The single-character token from the matrix header
+# @return The C source for the character literal
+def charLiteral(token):
+    if token == '\\' or token == '\'':
+        return "'\\" + token + "'"
+    return "'" + token + "'"
+
+char_data = readMatrix(CHAR_FILENAME)
+numChars = int(char_data[0][0])
+tokens = char_data[0][1:numChars+1]
+if numChars > 31:
+    print("Error: validator_table.h only supports up to 31 characters in " + CHAR_FILENAME)
+    sys.exit(1)
+
+# Map each row label ("start", "end", or a character) to its bitmask
+masks = {}
+for row in char_data[1:]:
+    masks[row[0]] = toMask(row[1:numChars+1])
+
+for previous, following in EVALUATOR_EXTRAS:
+    masks[previous] |= 1 << tokens.index(following)
+
+with open(TABLE_FILENAME, mode='w', newline='\n') as file:
+    file.write("// This file is generated by validator_generator.py from " + CHAR_FILENAME + ". Do not edit it by hand.\n")
+    file.write("#ifndef validator_table_h\n#define validator_table_h\n\n")
+    file.write("#define VALIDATOR_NUM_CLASSES " + str(numChars) + " //The number of character classes in the matrix\n")
+    file.write("#define VALIDATOR_START " + str(numChars) + " //The state before any character has been read\n")
+    file.write("#define VALIDATOR_INVALID 0xFF //The class of any character that is not in the matrix\n\n")
+
+    # The character class of every byte. Function names are looked up by their first letter and checked in validator.c
+    classes = ["0xff"] * 256
+    for index, token in enumerate(tokens):
+        classes[ord(token)] = str(index)
+    file.write("//The character class of every byte, or VALIDATOR_INVALID\n")
+    file.write("static const unsigned char VALIDATOR_CLASS[256] = {\n")
+    for start in range(0, 256, 16):
+        file.write("    " + ", ".join(classes[start:start+16]) + ",\n")
+    file.write("};\n\n")
+
+    file.write("//The token that each character class represents\n")
+    file.write("static const char VALIDATOR_TOKENS[VALIDATOR_NUM_CLASSES] = {\n")
+    file.write("    " + ", ".join(charLiteral(token) for token in tokens) + "\n")
+    file.write("};\n\n")
+
+    file.write("//Bit y of row x is set if class x can be followed by class y. Row VALIDATOR_START holds the valid starting classes.\n")
+    file.write("static const unsigned int VALIDATOR_TRANSITIONS[VALIDATOR_NUM_CLASSES+1] = {\n")
+    for token in tokens:
+        file.write("    0x%08x, // %s\n" % (masks[token], token))
+    file.write("    0x%08x  // start\n" % masks["start"])
+    file.write("};\n\n")
+
+    file.write("//Bit x is set if class x can end the expression\n")
+    file.write("static const unsigned int VALIDATOR_END = 0x%08x;\n\n" % masks["end"])
+    file.write("#endif\n")
+
+print(TABLE_FILENAME, "successfully written.")
@@ -0,0 +1,68 @@
+// This file is generated by validator_generator.py from char_matrix.csv. Do not edit it by hand.
+#ifndef validator_table_h
+#define validator_table_h
+
+#define VALIDATOR_NUM_CLASSES 26 //The number of character classes in the matrix
+#define VALIDATOR_START 26 //The state before any character has been read
+#define VALIDATOR_INVALID 0xFF //The class of any character that is not in the matrix
+
+//The character class of every byte, or VALIDATOR_INVALID
+static const unsigned char VALIDATOR_CLASS[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 22, 23, 13, 11, 0xff, 12, 10, 14,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 15, 0xff,
+    0xff, 0xff, 0xff, 17, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 20, 0xff, 21, 19,
+    0xff, 0xff, 0xff, 16, 18, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 24, 0xff, 25, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+//The token that each character class represents
+static const char VALIDATOR_TOKENS[VALIDATOR_NUM_CLASSES] = {
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '.', '+', '-', '*', '/', '^', 's', 'c', 't', 'o', 'l', 'n', '(', ')', '{', '}'
+};
+
+//Bit y of row x is set if class x can be followed by class y. Row VALIDATOR_START holds the valid starting classes.
+static const unsigned int VALIDATOR_TRANSITIONS[VALIDATOR_NUM_CLASSES+1] = {
+    0x0280ffff, // 0
+    0x0280ffff, // 1
+    0x0280ffff, // 2
+    0x0280ffff, // 3
+    0x0280ffff, // 4
+    0x0280ffff, // 5
+    0x0280ffff, // 6
+    0x0280ffff, // 7
+    0x0280ffff, // 8
+    0x0280ffff, // 9
+    0x000003ff, // .
+    0x017f13ff, // +
+    0x017f17ff, // -
+    0x017f13ff, // *
+    0x017f13ff, // /
+    0x017f13ff, // ^
+    0x017f13ff, // s
+    0x017f13ff, // c
+    0x017f13ff, // t
+    0x017f13ff, // o
+    0x017f13ff, // l
+    0x017f13ff, // n
+    0x017f17ff, // (
+    0x0280f800, // )
+    0x017f17ff, // {
+    0x0280f800, // }
+    0x017f17ff  // start
+};
+
+//Bit x is set if class x can end the expression
+static const unsigned int VALIDATOR_END = 0x028003ff;
+
+#endif